@@ -0,0 +1,68 @@
+#include <stdint.h>
+
+#include "hal.h"
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "fec.h"
+#include "rf.h"
+
+// received frames which do not pass the parity checks as they are come here from PROC,
+// the FEC runs at a lower priority thus it does not delay the time-slot work of PROC under heavy traffic.
+
+FIFO<RFM_RxPktData, 4> FEC_InpFIFO;           // frames which need correction: PROC -> FEC
+FIFO<FEC_RxResult,  4> FEC_OutFIFO;           // FEC results: FEC -> PROC
+
+static LDPC_LayeredDecoder<int8_t> Decoder;   // error corrector for the OGN Gallager code
+
+// receptions which failed FEC are kept till the end of the second: the same packet is often transmitted in both time slots
+// thus a failed reception in the second slot can be soft-combined with one from the first slot, which often recovers the packet.
+// A transmitter sends once per slot thus two receptions in the same slot are not the same packet,
+// relayed copies come in later seconds and differ in the relay count and thus in many parity bits.
+
+const  uint8_t       FailedPkts   = 4;        // number of failed receptions kept
+const  uint8_t       FailedMaxDist=64;        // [bits] more differing (non-erased) bits means it is not the same packet (random ones differ by ~100)
+static RFM_RxPktData FailedPkt[FailedPkts];   // Time==0 marks an empty entry
+static uint8_t       FailedPktIdx=0;          // where the next failed reception goes (round-robin)
+
+static uint8_t CombineRxPacket(RFM_RxPktData *RxPkt, OGN_RxPacket *RxPacket, uint8_t Check, uint8_t &Iter) // try to combine with earlier failed receptions
+{ uint8_t BestIdx=FailedPkts; uint8_t BestDist=FailedMaxDist+1;
+  for(uint8_t Idx=0; Idx<FailedPkts; Idx++)
+  { RFM_RxPktData &Failed = FailedPkt[Idx];
+    if(Failed.Time==0) continue;
+    if(Failed.Time!=RxPkt->Time) { Failed.Time=0; continue; } // expire the ones from earlier seconds
+    if(Failed.Slot()==RxPkt->Slot()) continue;               // same slot: another transmitter
+    uint8_t Dist=RxPkt->Distance(Failed);
+    if(Dist<BestDist) { BestIdx=Idx; BestDist=Dist; }       // take the most similar one
+  }
+  if(BestIdx<FailedPkts)
+  { Check = RxPkt->Decode(*RxPacket, FailedPkt[BestIdx], Decoder, 16, &Iter, RX_AverRSSI);
+    if( (Check==0) && (RxPacket->RxErr<15) )
+    { FailedPkt[BestIdx].Time=0; return 0; }                 // recovered: the stored reception is not needed anymore
+  }
+  FailedPkt[FailedPktIdx] = *RxPkt;                          // store this one for a future attempt
+  FailedPktIdx++; if(FailedPktIdx>=FailedPkts) FailedPktIdx=0;
+  return Check; }
+
+#ifdef __cplusplus
+  extern "C"
+#endif
+void vTaskFEC(void* pvParameters)
+{
+  for( ; ; )
+  { RFM_RxPktData *RxPkt = FEC_InpFIFO.getRead();               // frame to be corrected ?
+    if( (RxPkt==0) || FEC_OutFIFO.isFull() ) { vTaskDelay(1); continue; } // nothing to do or PROC did not yet take the previous results
+    FEC_RxResult *Result = FEC_OutFIFO.getWrite();
+    OGN_RxPacket *RxPacket = &Result->RxPacket;
+    RxPacket->Clear();
+    Result->Iter=0;
+    uint8_t Check = RxPkt->Decode(*RxPacket, Decoder, 16, &Result->Iter); // layered decoder: 16 iterations do better than 32 of the flooding one
+    if( (Check!=0) || (RxPacket->RxErr>=15) )
+      Check = CombineRxPacket(RxPkt, RxPacket, Check, Result->Iter); // failed: try soft-combining with an earlier reception
+    Result->Check=Check;
+    Result->Time=RxPkt->Time;
+    FEC_OutFIFO.Write();                                        // give the result back to PROC
+    FEC_InpFIFO.Read(); }                                       // and release the input frame
+
+}
@@ -0,0 +1,26 @@
+#include <stdint.h>
+
+#include "hal.h"
+
+#ifdef __cplusplus
+
+#include "ogn.h"
+#include "rfm.h"
+#include "fifo.h"
+
+class FEC_RxResult                            // frame which went through the FEC task, returned to PROC
+{ public:
+   OGN_RxPacket RxPacket;                     // corrected packet, still whitened
+   uint8_t      Check;                        // number of failed parity checks: zero means a good packet
+   uint8_t      Iter;                         // soft-decoder iterations used
+   uint32_t     Time;                         // [sec] time slot of the reception
+} ;
+
+  extern FIFO<RFM_RxPktData, 4> FEC_InpFIFO;  // frames which need correction: PROC -> FEC
+  extern FIFO<FEC_RxResult,  4> FEC_OutFIFO;  // FEC results: FEC -> PROC
+#endif
+
+#ifdef __cplusplus
+  extern "C"
+#endif
+ void vTaskFEC(void* pvParameters);
@@ -0,0 +1,23 @@
+#ifndef __HOSTTEST_H__
+#define __HOSTTEST_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+// helpers shared by the host test programs (*_test.cc): channel noise and a cycle counter for the timing
+
+static inline double UniformNoise(void) { return (random()+0.5)/((double)RAND_MAX+1.0); } // (0..1) never exactly 0 or 1
+
+static inline double GaussNoise(void)                            // Box-Muller
+{ double R = sqrt(-2*log(UniformNoise()));
+  return R*cos(2*M_PI*UniformNoise()); }
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t Cycles(void) { return __builtin_ia32_rdtsc(); }
+#else
+static inline uint64_t Cycles(void) { return clock(); }      // no cycle counter: CPU clock ticks
+#endif
+
+#endif // __HOSTTEST_H__
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 
 #include "ldpc.h"
+#include "ldpc_tables.h"
 
 #ifndef __AVR__
 #include <math.h>
@@ -16,7 +17,7 @@
 // FindVectors65432bit(10,20,23, 500) => 208, Delta=2579
 
 // every row represents a parity check to be performed on the received codeword
-static const uint32_t LDPC_ParityCheck_n208k160[48][7]
+constexpr uint32_t LDPC_ParityCheck_n208k160[48][7]
 #ifdef __AVR__
 PROGMEM
 #endif
@@ -73,75 +74,27 @@ PROGMEM
 } ;
 
 
-const uint8_t LDPC_ParityCheckIndex_n208k160[48][24]
+// the decoder tables are derived from the parity-check matrix above at compile time (ldpc_tables.h)
+
+constexpr LDPC_IndexTable<48, 24> LDPC_ParityCheckIndexTable_n208k160 // number of, indicies to bits to be taken for parity checks
 #ifdef __AVR__
 PROGMEM
 #endif
-= { // number of, indicies to bits to be taken for parity checks
- { 10,   0,   2,  11,  37,  90, 125, 134, 165, 174, 178 },
- { 11,   0,  43,  55, 176, 188, 195, 196, 199, 202, 203, 207 },
- { 11,   0,  14,  39,  56,  74,  95, 137, 155, 181, 192, 194, },
- { 14,   0,   8,  41,  61,  65,  69, 175, 186, 187, 190, 191, 193, 204, 206 },
- { 15,   0,  10,  72,  75,  78, 101, 160, 163, 166, 168, 169, 182, 183, 189, 197 },
- { 21,   0,  18,  20,  24,  25,  33,  96, 126, 136, 142, 144, 145, 148, 150, 152, 158, 170, 171, 173, 180, 205 },
- { 18,  11,  15,  26,  33,  38,  41,  42,  57,  63, 101, 133, 146, 155, 159, 164, 184, 185, 202 },
- { 17,   1,  11,  61,  66,  68,  89, 117, 120, 128, 129, 138, 154, 162, 183, 194, 205, 207 },
- { 18,   5,  11,  17,  25,  69,  75,  81,  95, 102, 112, 115, 116, 124, 156, 157, 161, 200, 203 },
- { 18,   4,   6,   8,  11,  14,  23,  30,  48,  51,  98, 105, 108, 113, 140, 158, 168, 172, 188 },
- { 17,   9,  11,  27,  35,  49,  82, 100, 118, 121, 141, 152, 167, 169, 179, 181, 190, 196 },
- { 17,  36,  47,  69,  71,  87,  88,  92, 103, 114, 130, 135, 152, 168, 178, 194, 198, 202 },
- { 18,   3,   8,  18,  29,  59,  60,  75,  79,  85,  86,  91,  97,  99, 132, 155, 167, 178, 207 },
- { 16,   7,  14,  32,  41,  45,  49,  54,  80, 106, 109, 111, 139, 150, 178, 183, 203 },
- { 15,  53,  61,  62,  70,  73,  84,  95,  96, 101, 123, 151, 153, 178, 179, 188 },
- { 14,  12,  33,  48,  56,  64,  77,  83, 122, 128, 161, 178, 196, 197, 206 },
- { 13,   8,   9,  13,  58,  83,  93,  95, 110, 125, 143, 145, 183, 202 },
- { 15,  14,  40,  46,  52,  67,  69,  76,  82,  94, 101, 122, 125, 149, 180, 207 },
- { 14,  12,  16,  27,  50,  61, 119, 125, 127, 144, 147, 155, 168, 201, 203 },
- { 12,  19,  20,  28,  34,  41,  75,  77, 107, 118, 125, 188, 194 },
- { 13,  62,  63,  85,  92, 111, 113, 125, 157, 163, 191, 192, 196, 205 },
- { 10,  14,  25,  31,  61,  77,  85,  90, 169, 177, 202 },
- { 12,  21,  22,  27,  41,  44,  90,  92,  95, 131, 158, 197, 207 },
- { 12,  18,  26,  48,  58,  84,  90, 104, 149, 163, 190, 194, 203 },
- { 11,   9,  36,  40,  72,  90, 138, 150, 155, 157, 188, 206 },
- { 17,  19,  39,  76,  90,  96,  97,  98, 109, 115, 119, 120, 130, 133, 143, 160, 186, 196 },
- { 15,  21,  29,  37,  70,  80, 107, 120, 127, 140, 156, 163, 180, 181, 202, 206 },
- { 19,   4,  28,  31,  32,  37,  44,  50,  55,  56,  59,  63,  67,  68,  72, 115, 123, 145, 190, 198 },
- { 18,  17,  22,  23,  26,  34,  36,  37,  46,  54,  60, 110, 128, 144, 151, 169, 186, 192, 195 },
- { 18,  13,  20,  30,  37,  39,  45,  57,  84,  94, 103, 116, 138, 147, 167, 176, 177, 191, 197 },
- { 18,  16,  37,  40,  43,  49,  58,  73, 113, 114, 131, 132, 137, 160, 161, 162, 173, 184, 204 },
- { 17,   3,  17,  38,  47,  53,  55,  83, 106, 108, 126, 134, 149, 154, 160, 181, 191, 201 },
- { 16,   1,  10,  30,  52,  56,  79,  87,  93, 111, 133, 134, 148, 156, 179, 195, 204 },
- { 17,   5,   7,  12,  29,  72,  82,  88,  98, 104, 129, 134, 146, 153, 173, 176, 187, 192 },
- { 16,  24,  39,  43,  60,  62,  65,  68,  71, 118, 122, 124, 134, 139, 140, 182, 185 },
- { 13,   4,  57,  78,  80,  99, 100, 117, 134, 137, 171, 186, 199, 200 },
- { 14,  15,  35,  51,  55,  66,  70,  91, 116, 130, 165, 171, 182, 192, 204 },
- { 14,  24,  45,  64,  78,  89,  97, 102, 165, 172, 181, 184, 187, 195, 198 },
- { 15,  23,  42,  56,  65,  86, 109, 126, 127, 135, 141, 162, 165, 166, 176, 200 },
- { 14,  10,  38,  43,  54,  59,  74, 100, 103, 107, 129, 136, 143, 165, 193 },
- { 15,   6,  21,  32,  39, 112, 114, 121, 146, 148, 151, 154, 165, 175, 189, 199 },
- { 12,   2,  10,  55,  76, 110, 112, 137, 141, 147, 170, 185, 187 },
- { 14,   2,   5,  13,  15,  65,  74, 108, 117, 119, 123, 132, 142, 189, 195 },
- { 14,   1,   2,   6,  19,  22,  47,  67,  73,  99, 102, 164, 176, 182, 193 },
- { 14,   2,   3,   7,  42,  43,  46,  50,  66,  78,  81,  87, 105, 175, 177 },
- { 14,   2,  16,  28,  51,  79,  88,  89,  94, 106, 124, 136, 159, 166, 199 },
- { 16,  31,  34,  35,  53,  71,  74,  81,  86,  93, 104, 131, 164, 170, 172, 174, 199 },
- { 15,  44,  52,  64,  91, 105, 121, 135, 137, 139, 142, 153, 159, 174, 193, 201 }
-  } ;
-
-static const uint8_t LDPC_BitWeight_n208k160[208] // weight of parity checks for every codeword bit
+ = LDPC_CheckIndex<24>(LDPC_ParityCheck_n208k160, 208);
+
+const uint8_t (&LDPC_ParityCheckIndex_n208k160)[48][24] = LDPC_ParityCheckIndexTable_n208k160.Index;
+
+// codeword bits grouped by their weight (3, 4, 5 or 6 parity checks): for the bit-flipping decoder
+constexpr LDPC_MaskTable<4, 7> LDPC_BitWeightMaskTable_n208k160
 #ifdef __AVR__
 PROGMEM
 #endif
-= { 6, 3, 6, 3, 3, 3, 3, 3, 4, 3, 4, 6, 3, 3, 5, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
-    3, 3, 3, 3, 3, 6, 3, 5, 3, 5, 3, 5, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 5, 5, 3, 3, 3, 3, 5, 3, 3,
-    3, 4, 3, 3, 3, 4, 3, 3, 4, 3, 4, 4, 3, 3, 4, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 6, 3, 3, 3, 3, 5,
-    3, 3, 3, 3, 3, 4, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 6, 3, 3,
-    3, 3, 3, 3, 3, 3, 6, 3, 3, 5, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 5, 3, 3, 3, 3,
-    4, 3, 3, 4, 3, 6, 3, 3, 4, 4, 3, 3, 3, 3, 3, 3, 5, 3, 6, 3, 3, 5, 4, 4, 3, 3, 4, 4, 5, 3, 4, 4,
-    5, 4, 5, 5, 5, 4, 3, 5, 3, 3, 6, 5, 4, 3, 4, 5 } ;
+ = LDPC_BitWeightMask<208, 3, 4>(LDPC_ParityCheck_n208k160);
+
+static const uint32_t (&LDPC_BitWeightMask_n208k160)[4][7] = LDPC_BitWeightMaskTable_n208k160.Mask;
 
 // every row represents the generator for a parity bit
-static const uint32_t LDPC_ParityGen_n208k160[48][5]
+constexpr uint32_t LDPC_ParityGen_n208k160[48][5]
 #ifdef __AVR__
 PROGMEM
 #endif
@@ -202,7 +155,7 @@ PROGMEM
 
 #ifdef WITH_PPM
 
-const uint32_t LDPC_ParityCheck_n354k160[194][12] // 354 codeword = 160 user bits + 194 parity checks
+constexpr uint32_t LDPC_ParityCheck_n354k160[194][12] // 354 codeword = 160 user bits + 194 parity checks
 #ifdef __AVR__
 PROGMEM
 #endif
@@ -403,6 +356,14 @@ PROGMEM
  { 0x00100082, 0x00000000, 0x20008000, 0x00000000, 0x00000000, 0x00004000, 0x00000800, 0x00000000, 0x00000000, 0x00001000, 0x00000000, 0x00000002 }  
 } ;
 
+constexpr LDPC_IndexTable<194, 12, uint16_t> LDPC_ParityCheckIndexTable_n354k160 // for the PPM decoder
+#ifdef __AVR__
+PROGMEM
+#endif
+ = LDPC_CheckIndex<12, uint16_t>(LDPC_ParityCheck_n354k160, 354);
+
+const uint16_t (&LDPC_ParityCheckIndex_n354k160)[194][12] = LDPC_ParityCheckIndexTable_n354k160.Index;
+
 const uint32_t LDPC_ParityGen_n354k160[194][5]
 #ifdef __AVR__
 PROGMEM
@@ -697,8 +658,66 @@ static void LDPC_Encode(const uint32_t *Data, uint32_t *Parity, uint8_t DataWord
   // printf(" => %08X %08X\n", Parity[0], Parity[1] );
 }
 
+void LDPC_Encode_Gen(const uint32_t *Data, uint32_t *Parity) { LDPC_Encode(Data, Parity, 5, 48, (uint32_t *)LDPC_ParityGen_n208k160); }
+
+// table-driven encoder: the parity is a linear function of the data thus it is the XOR of the parity contributions
+// of every 4-bit (nibble) or 8-bit (byte) piece of the data. The tables are derived from the generator rows at compile time.
+// Select by the flash budget: WITH_LDPC_ENC_NIBBLE: 3.75KB of tables, WITH_LDPC_ENC_BYTE: 30KB of tables
+
+#ifdef WITH_LDPC_ENC_NIBBLE
+static constexpr LDPC_PieceTable<40, 16> LDPC_ParityTabNibble_n208k160 = LDPC_PieceParity<4>(LDPC_ParityGen_n208k160);
+
+void LDPC_Encode_Nibble(const uint32_t *Data, uint32_t *Parity)
+{ uint32_t ParLow=0; uint16_t ParHigh=0;
+  uint8_t Piece=0;
+  for(uint8_t Idx=0; Idx<5; Idx++)
+  { uint32_t Word=Data[Idx];
+    for(uint8_t Nibble=0; Nibble<8; Nibble++, Piece++)
+    { uint8_t Val=Word&0x0F;
+      ParLow ^=LDPC_ParityTabNibble_n208k160.Low [Piece][Val];
+      ParHigh^=LDPC_ParityTabNibble_n208k160.High[Piece][Val];
+      Word>>=4; }
+  }
+  Parity[0]=ParLow; Parity[1]=ParHigh; }
+#endif // WITH_LDPC_ENC_NIBBLE
+
+#ifdef WITH_LDPC_ENC_BYTE
+static constexpr LDPC_PieceTable<20, 256> LDPC_ParityTabByte_n208k160 = LDPC_PieceParity<8>(LDPC_ParityGen_n208k160);
+
+void LDPC_Encode_Byte(const uint32_t *Data, uint32_t *Parity)
+{ uint32_t ParLow=0; uint16_t ParHigh=0;
+  uint8_t Piece=0;
+  for(uint8_t Idx=0; Idx<5; Idx++)
+  { uint32_t Word=Data[Idx];
+    for(uint8_t Byte=0; Byte<4; Byte++, Piece++)
+    { uint8_t Val=Word&0xFF;
+      ParLow ^=LDPC_ParityTabByte_n208k160.Low [Piece][Val];
+      ParHigh^=LDPC_ParityTabByte_n208k160.High[Piece][Val];
+      Word>>=8; }
+  }
+  Parity[0]=ParLow; Parity[1]=ParHigh; }
+#endif // WITH_LDPC_ENC_BYTE
+
+// parity bits flipped by every bit of the first data word (the packet header): 256 bytes of flash
+static constexpr LDPC_ColumnTable<32, 2> LDPC_HeaderParity_n208k160 = LDPC_ParityColumns<32>(LDPC_ParityGen_n208k160, 0);
+
+void LDPC_PatchHeader(uint32_t *Parity, uint32_t HeaderDiff)
+{ while(HeaderDiff)
+  { uint8_t Bit=__builtin_ctz(HeaderDiff); HeaderDiff&=HeaderDiff-1;
+    const uint32_t *Column=LDPC_HeaderParity_n208k160.Column[Bit];
+    Parity[0]^=Column[0]; Parity[1]^=Column[1]; }
+}
+
+#if defined(WITH_LDPC_ENC_BYTE)
+void LDPC_Encode(const uint32_t *Data, uint32_t *Parity) { LDPC_Encode_Byte(Data, Parity); }
+void LDPC_Encode(      uint32_t *Data)                   { LDPC_Encode_Byte(Data, Data+5); }
+#elif defined(WITH_LDPC_ENC_NIBBLE)
+void LDPC_Encode(const uint32_t *Data, uint32_t *Parity) { LDPC_Encode_Nibble(Data, Parity); }
+void LDPC_Encode(      uint32_t *Data)                   { LDPC_Encode_Nibble(Data, Data+5); }
+#else
 void LDPC_Encode(const uint32_t *Data, uint32_t *Parity) { LDPC_Encode(Data, Parity, 5, 48, (uint32_t *)LDPC_ParityGen_n208k160); }
 void LDPC_Encode(      uint32_t *Data)                   { LDPC_Encode(Data, Data+5, 5, 48, (uint32_t *)LDPC_ParityGen_n208k160); }
+#endif
 
 #ifdef WITH_PPM
 void LDPC_Encode_n354k160(const uint32_t *Data, uint32_t *Parity) { LDPC_Encode(Data, Parity, 5, 194, (uint32_t *)LDPC_ParityGen_n354k160); }
@@ -730,6 +749,57 @@ uint8_t LDPC_Check(const uint8_t *Data) // 20 data bytes followed by 6 parity by
     { uint8_t And = Data[Idx]&Check[Idx]; Count+=Count1s(And); }
     if(Count&1) Errors++; }
   return Errors; }
+
+// hard-decision (Gallager-B) bit-flipping: first the bits marked as erased (Manchester errors) are flipped
+// when at least half of their parity checks fail, if there are none, then any bit for which the majority of checks fail.
+// The failed checks are counted for all bits in parallel on bit-sliced 3-bit counters.
+// A codeword reached by changing more than MaxCorr not-erased bits is not accepted (returns 0xFF) as such are often false:
+// ldpc_fer -c manch with the layered decoder behind gives 26 (6dB) and 8 (7dB) false decodes per 50000 packets
+// with any change allowed, 21 and 1 with none, while the layered decoder alone gives 20 and 1.
+uint8_t LDPC_FlipBits(uint32_t *Data, const uint32_t *Erased, uint8_t MaxIter, uint8_t MaxCorr) // Data and Erased are 7 32-bit words = 208 bits
+{ uint8_t Errors=0;
+  uint32_t Changed[7];                                        // bits changed so far
+  for(uint8_t Idx=0; Idx<7; Idx++) Changed[Idx]=0;
+  for(uint8_t Iter=0; ; Iter++)
+  { uint32_t Cnt0[7], Cnt1[7], Cnt2[7];                      // number of failed checks for every bit
+    for(uint8_t Idx=0; Idx<7; Idx++)
+    { Cnt0[Idx]=0; Cnt1[Idx]=0; Cnt2[Idx]=0; }
+    Errors=0;
+    for(uint8_t Row=0; Row<48; Row++)
+    { const uint32_t *Check=LDPC_ParityCheck_n208k160[Row];
+      uint32_t Word=0;
+      for(uint8_t Idx=0; Idx<7; Idx++)
+        Word^=Data[Idx]&Check[Idx];
+      if((Count1s(Word)&1)==0) continue;                      // this check is fine
+      Errors++;
+      for(uint8_t Idx=0; Idx<7; Idx++)                        // add one to the counters of the bits in this check
+      { uint32_t Carry=Check[Idx];
+        uint32_t Next=Cnt0[Idx]&Carry; Cnt0[Idx]^=Carry; Carry=Next;
+                 Next=Cnt1[Idx]&Carry; Cnt1[Idx]^=Carry; Cnt2[Idx]|=Next; }
+    }
+    if( (Errors==0) || (Iter>=MaxIter) ) break;
+    uint32_t Flipped=0;
+    for(uint8_t Pass=0; Pass<2; Pass++)                       // pass 0: erased bits only, pass 1: all bits
+    { for(uint8_t Idx=0; Idx<7; Idx++)
+      { uint32_t Ge2 = Cnt1[Idx]|Cnt2[Idx];                   // two or more checks fail
+        uint32_t Ge3 = Cnt2[Idx]|(Cnt1[Idx]&Cnt0[Idx]);       // three or more
+        uint32_t Ge4 = Cnt2[Idx];                             // four or more
+        uint32_t W3  = LDPC_BitWeightMask_n208k160[0][Idx];
+        uint32_t W4  = LDPC_BitWeightMask_n208k160[1][Idx];
+        uint32_t W5  = LDPC_BitWeightMask_n208k160[2][Idx];
+        uint32_t W6  = LDPC_BitWeightMask_n208k160[3][Idx];
+        uint32_t Flip;
+        if(Pass==0) Flip = Erased[Idx] & ( (Ge2&(W3|W4)) | (Ge3&(W5|W6)) );
+               else Flip = (Ge2&W3) | (Ge3&(W4|W5)) | (Ge4&W6);
+        Data[Idx]^=Flip; Changed[Idx]^=Flip; Flipped|=Flip; }
+      if(Flipped) break; }
+    if(Flipped==0) break; }                                   // no bit to flip: give up
+  if(Errors) return Errors;
+  uint8_t Corr=0;
+  for(uint8_t Idx=0; Idx<7; Idx++)
+    Corr+=Count1s(Changed[Idx]&(~Erased[Idx]));
+  if(Corr>MaxCorr) return 0xFF;                               // valid codeword but too far from the received bits
+  return 0; }
 #ifdef WITH_PPM
 uint8_t LDPC_Check_n354k160(const uint32_t *Data, const uint32_t *Parity) // Data and Parity are 32-bit words
 { uint8_t Errors=0;
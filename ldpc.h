@@ -57,6 +57,14 @@ void LDPC_Encode(      uint8_t *Data);
 
 void LDPC_Encode(const uint32_t *Data, uint32_t *Parity);
 void LDPC_Encode(      uint32_t *Data);
+void LDPC_Encode_Gen(const uint32_t *Data, uint32_t *Parity);    // generator rows with bit counting: no extra flash
+void LDPC_PatchHeader(uint32_t *Parity, uint32_t HeaderDiff);    // update Parity for the header (first data word) bits flipped by HeaderDiff
+#ifdef WITH_LDPC_ENC_NIBBLE
+void LDPC_Encode_Nibble(const uint32_t *Data, uint32_t *Parity); // table-driven: 4-bit pieces, 3.75KB of tables
+#endif
+#ifdef WITH_LDPC_ENC_BYTE
+void LDPC_Encode_Byte(const uint32_t *Data, uint32_t *Parity);   // table-driven: 8-bit pieces, 30KB of tables
+#endif
 #ifdef WITH_PPM
 void LDPC_Encode_n354k160(const uint32_t *Data, uint32_t *Parity);
 void LDPC_Encode_n354k160(      uint32_t *Data);
@@ -65,6 +73,9 @@ void LDPC_Encode_n354k160(      uint32_t *Data);
 uint8_t LDPC_Check(const uint32_t *Data, const uint32_t *Parity); // Data and Parity are 32-bit words
 uint8_t LDPC_Check(const uint32_t *Data);
 uint8_t LDPC_Check(const uint8_t  *Data);                         // 20 data bytes followed by 6 parity bytes
+                                                                  // hard-decision bit-flipping: correct Data in place, return number of failed checks
+                                                                  // or 0xFF when more than MaxCorr not-erased bits had to be changed
+uint8_t LDPC_FlipBits(uint32_t *Data, const uint32_t *Erased, uint8_t MaxIter=8, uint8_t MaxCorr=0);
 #ifdef WITH_PPM
 uint8_t LDPC_Check_n354k160(const uint32_t *Data, const uint32_t *Parity); // Data and Parity are 32-bit words
 uint8_t LDPC_Check_n354k160(const uint32_t *Data);
@@ -74,7 +85,15 @@ uint8_t LDPC_Check_n354k160(const uint32_t *Data);
 
 #ifndef __AVR__
 
-extern const uint8_t LDPC_ParityCheckIndex_n208k160[48][24];
+extern const uint32_t LDPC_ParityCheck_n208k160[48][7];
+extern const uint8_t (&LDPC_ParityCheckIndex_n208k160)[48][24]; // derived from LDPC_ParityCheck_n208k160 at compile time
+
+inline uint8_t LDPC_NearErased(const uint8_t *Err, uint8_t Idx, uint8_t Bytes) // bits next to an erased one: bytes are sent MSB first
+{ uint8_t ErrByte=Err[Idx];
+  uint8_t Near = (ErrByte<<1) | (ErrByte>>1);
+  if( (Idx>0)       && (Err[Idx-1]&0x01) ) Near|=0x80;     // LSB of the previous byte is just before our MSB
+  if( (Idx+1<Bytes) && (Err[Idx+1]&0x80) ) Near|=0x01;     // MSB of the next byte is just after our LSB
+  return Near&(~ErrByte); }
 
 class LDPC_Decoder
 { public:
@@ -105,6 +124,28 @@ class LDPC_Decoder
      }
    }
 
+   void Input(const uint8_t *Data, const uint8_t *Err, uint8_t Weight, uint8_t NearWeight) // reliability-weighted, see addInput()
+   { for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+       InpBit[Bit]=0;
+     addInput(Data, Err, Weight, NearWeight); }
+
+   // add another reception of the same codeword (soft combining): [1/16] Weight scales all bits,
+   // NearWeight the bits next to a Manchester error (they are often hit by the same interference)
+   void addInput(const uint8_t *Data, const uint8_t *Err, uint8_t Weight=16, uint8_t NearWeight=16)
+   { int16_t Ampl     = ((int16_t)Weight    <<3);
+     int16_t NearAmpl = ((int16_t)NearWeight<<3);
+     for(uint8_t Idx=0; Idx<CodeBytes; Idx++)
+     { uint8_t DataByte=Data[Idx]; uint8_t ErrByte=Err[Idx];
+       uint8_t Near=LDPC_NearErased(Err, Idx, CodeBytes);
+       uint8_t Mask=1;
+       for(uint8_t Bit=Idx*8; Bit<Idx*8+8; Bit++, Mask<<=1)
+       { if((ErrByte&Mask)==0)
+         { int16_t Inp = (Near&Mask) ? NearAmpl:Ampl;
+           InpBit[Bit] += (DataByte&Mask) ? Inp:-Inp; }
+         OutBit[Bit] = InpBit[Bit]; ExtBit[Bit]=0; }
+     }
+   }
+
    void Input(const uint32_t Data[CodeWords])
    { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=Data[Idx];
      for(uint8_t Bit=0; Bit<CodeBits; Bit++)
@@ -122,7 +163,7 @@ class LDPC_Decoder
        ExtBit[Bit]=0; }
    }
 
-   void Output(uint32_t Data[CodeWords])
+   void Output(uint32_t Data[CodeWords]) const
    { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=0;
      for(uint8_t Bit=0; Bit<CodeBits; Bit++)
      { if(OutBit[Bit]>0) Word|=Mask;
@@ -130,7 +171,7 @@ class LDPC_Decoder
      } if(Mask>1) Data[Idx++]=Word;
    }
 
-   void Output(uint8_t Data[CodeBytes])
+   void Output(uint8_t Data[CodeBytes]) const
    { uint8_t Mask=1; uint8_t Idx=0; uint8_t Byte=0;
      for(uint8_t Bit=0; Bit<CodeBits; Bit++)
      { if(OutBit[Bit]>0) Byte|=Mask;
@@ -177,6 +218,209 @@ class LDPC_Decoder
 
 } ;
 
+// layered (row-serial) min-sum decoder: the a-posteriori bits are updated after every parity check
+// thus the information propagates faster than with the flooding schedule of LDPC_Decoder.
+// The check-to-bit messages are kept per row in compressed form: two smallest amplitudes, index of the smallest and the signs.
+// LLR=int16_t takes about 850 bytes of RAM, LLR=int8_t (saturated) about 550 bytes, LDPC_Decoder takes 1250 bytes.
+template <class LLR=int16_t>
+ class LDPC_LayeredDecoder
+{ public:
+   const static uint8_t UserBits   = 160;                 // 5 32-bit bits = 20 bytes
+   const static uint8_t UserWords  = UserBits/32;
+   const static uint8_t ParityBits =  48;                 // 6 bytes (total packet is 26 bytes)
+   const static uint8_t CodeBits   = UserBits+ParityBits; // 160+48 = 208 code bits = 26 bytes
+   const static uint8_t CodeBytes  = (CodeBits+ 7)/ 8;    //
+   const static uint8_t CodeWords  = (CodeBits+31)/32;    //
+   const static uint8_t MaxCheckWeight = 24;
+
+   const static LLR MaxAmpl   = sizeof(LLR)>1 ? 32767:127;  // saturation limit
+   const static LLR InpAmpl   = 16;                         // hard input bit: low enough that 8-bit LLRs rarely saturate
+   const static LLR FloatAmpl = sizeof(LLR)>1 ?   128: 16;  // soft input bit of RefAmpl
+
+  public:
+
+   LLR      OutBit[CodeBits];       // a-posteriori bits
+
+   LLR      CheckMin[ParityBits];   // smallest (corrected) amplitude among the bits of the check
+   LLR      CheckMin2[ParityBits];  // 2nd smallest (corrected) amplitude
+   uint8_t  CheckMinBit[ParityBits];// which bit (within the check) has the smallest amplitude
+   uint32_t CheckWord[ParityBits];  // hard decisions of the bit-to-check messages: 1 = positive
+
+   uint8_t  Scale;                  // [1/16] normalized min-sum: scale the check-to-bit amplitudes
+   uint8_t  Offset;                 // offset min-sum: subtract from the check-to-bit amplitudes
+
+  public:
+
+   LDPC_LayeredDecoder() { Scale=14; Offset=0; }       // Scale=14/16 gave the lowest FER on the AWGN benchmark (ldpc_test.cc)
+
+   void ClearChecks(void)
+   { for(uint8_t Row=0; Row<ParityBits; Row++)
+     { CheckMin[Row]=0; CheckMin2[Row]=0; CheckMinBit[Row]=0; CheckWord[Row]=0; }
+   }
+
+   void Input(const uint8_t *Data, const uint8_t *Err)
+   { uint8_t Mask=1; uint8_t Idx=0; uint8_t DataByte=0; uint8_t ErrByte=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(Mask==1) { DataByte=Data[Idx];  ErrByte=Err[Idx]; }
+       LLR Inp;
+       if(ErrByte&Mask) Inp=0;
+                   else Inp=(DataByte&Mask) ? +InpAmpl:-InpAmpl;
+       OutBit[Bit] = Inp;
+       Mask<<=1; if(Mask==0) { Idx++; Mask=1; }
+     }
+     ClearChecks(); }
+
+   void Input(const uint8_t *Data, const uint8_t *Err, uint8_t Weight, uint8_t NearWeight) // reliability-weighted, see addInput()
+   { for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+       OutBit[Bit]=0;
+     addInput(Data, Err, Weight, NearWeight); }
+
+   // add another reception of the same codeword (soft combining): [1/16] Weight scales all bits,
+   // NearWeight the bits next to a Manchester error (they are often hit by the same interference)
+   void addInput(const uint8_t *Data, const uint8_t *Err, uint8_t Weight=16, uint8_t NearWeight=16)
+   { LLR Ampl     = Saturate(((int32_t)InpAmpl*Weight    +8)>>4);
+     LLR NearAmpl = Saturate(((int32_t)InpAmpl*NearWeight+8)>>4);
+     for(uint8_t Idx=0; Idx<CodeBytes; Idx++)
+     { uint8_t DataByte=Data[Idx]; uint8_t ErrByte=Err[Idx];
+       uint8_t Near=LDPC_NearErased(Err, Idx, CodeBytes);
+       uint8_t Mask=1;
+       for(uint8_t Bit=Idx*8; Bit<Idx*8+8; Bit++, Mask<<=1)
+       { if(ErrByte&Mask) continue;
+         LLR Inp = (Near&Mask) ? NearAmpl:Ampl;
+         OutBit[Bit] = Saturate((int32_t)OutBit[Bit] + ((DataByte&Mask) ? Inp:-Inp)); }
+     }
+     ClearChecks(); }
+
+   void Input(const uint32_t Data[CodeWords])
+   { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=Data[Idx];
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { OutBit[Bit] = (Word&Mask) ? +InpAmpl:-InpAmpl;
+       Mask<<=1; if(Mask==0) { Word=Data[++Idx]; Mask=1; }
+     }
+     ClearChecks(); }
+
+   void Input(const float *Data, float RefAmpl=1.0)
+   { for(int Bit=0; Bit<CodeBits; Bit++)
+     { int Inp = floor(FloatAmpl*Data[Bit^7]/RefAmpl+0.5);
+       OutBit[Bit] = Saturate(Inp); }
+     ClearChecks(); }
+
+   void Output(uint32_t Data[CodeWords]) const
+   { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(OutBit[Bit]>0) Word|=Mask;
+       Mask<<=1; if(Mask==0) { Data[Idx++]=Word; Word=0; Mask=1; }
+     } if(Mask>1) Data[Idx++]=Word;
+   }
+
+   void Output(uint8_t Data[CodeBytes]) const
+   { uint8_t Mask=1; uint8_t Idx=0; uint8_t Byte=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(OutBit[Bit]>0) Byte|=Mask;
+       Mask<<=1; if(Mask==0) { Data[Idx++]=Byte; Byte=0; Mask=1; }
+     } if(Mask>1) Data[Idx++]=Byte;
+   }
+
+   uint8_t CountFailedChecks(void) const                 // run the 48 parity checks on the hard decisions
+   { uint32_t Data[CodeWords]; Output(Data);
+     return LDPC_Check(Data); }
+
+   int8_t ProcessChecks(void)                            // one iteration: returns number of failed checks before the iteration
+   { uint8_t Count=CountFailedChecks();
+     if(Count==0) return 0;                              // if all checks pass: nothing to do
+     for(uint8_t Row=0; Row<ParityBits; Row++)
+       ProcessCheck(Row);
+     return Count; }
+
+   LLR CorrectAmpl(int16_t Ampl) const                   // normalized/offset min-sum correction
+   { Ampl = ((int32_t)Ampl*Scale+8)>>4;
+     if(Ampl<=Offset) return 0;
+     return Ampl-Offset; }
+
+   static LLR Saturate(int32_t Ampl)
+   { if(Ampl>MaxAmpl) return MaxAmpl;
+     if(Ampl<(-MaxAmpl)) return -MaxAmpl;
+     return Ampl; }
+
+   void ProcessCheck(uint8_t Row)
+   { const uint8_t *CheckIndex = LDPC_ParityCheckIndex_n208k160[Row];
+     uint8_t CheckWeight = *CheckIndex++;
+     LLR OldMin=CheckMin[Row]; LLR OldMin2=CheckMin2[Row]; uint8_t OldMinBit=CheckMinBit[Row];
+     uint32_t OldWord=CheckWord[Row]; uint8_t OldFails=Count1s(OldWord)&1;
+     LLR MinAmpl=MaxAmpl; uint8_t MinBit=0; LLR MinAmpl2=MinAmpl;
+     uint32_t Word=0; uint32_t Mask=1;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)             // remove the old check-to-bit message and find the two smallest bit-to-check
+     { uint8_t BitIdx=CheckIndex[Bit];
+       int16_t Old = Bit==OldMinBit ? OldMin2:OldMin;
+       if( ((OldWord&Mask)!=0) == (OldFails!=0) ) Old=(-Old);
+       LLR Ampl=Saturate((int32_t)OutBit[BitIdx]-Old);
+       OutBit[BitIdx]=Ampl;
+       if(Ampl>0) Word|=Mask;
+       Mask<<=1;
+       if(Ampl<0) Ampl=(-Ampl);
+       if(Ampl<MinAmpl) { MinAmpl2=MinAmpl; MinAmpl=Ampl; MinBit=Bit; }
+       else if(Ampl<MinAmpl2) { MinAmpl2=Ampl; }
+     }
+     MinAmpl=CorrectAmpl(MinAmpl); MinAmpl2=CorrectAmpl(MinAmpl2);
+     uint8_t CheckFails = Count1s(Word)&1;
+     Mask=1;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)             // add the new check-to-bit message
+     { uint8_t BitIdx=CheckIndex[Bit];
+       int16_t Ampl = Bit==MinBit ? MinAmpl2 : MinAmpl;
+       if( ((Word&Mask)!=0) == (CheckFails!=0) ) Ampl=(-Ampl);
+       OutBit[BitIdx] = Saturate((int32_t)OutBit[BitIdx]+Ampl);
+       Mask<<=1; }
+     CheckMin[Row]=MinAmpl; CheckMin2[Row]=MinAmpl2; CheckMinBit[Row]=MinBit; CheckWord[Row]=Word; }
+
+} ;
+
+// decides when to give up iterating on a codeword which is not going to decode (noise, FLARM or other non-OGN frames):
+// after MinIter iterations still too many checks fail, or the hard decisions keep coming back
+// to the same pattern with the checks still failing (oscillation or a trapping set).
+// Thresholds are from the host FER benchmark (ldpc_fer.cc) with the 16 iterations of the tracker:
+// a noise frame takes 12.7 iterations on average instead of 16, at the cost of FER 0.162 -> 0.165 at 5dB.
+// A stall rule (failed-check count not improving) never fired before the 16 iterations without losing more.
+// The worst case per frame stays 16 iterations: each one is about 1.4k bit updates (717 edges, two passes)
+// plus the 48 checks, estimated 25k cycles on the Cortex-M3, thus 0.4M cycles (5.5ms at 72MHz) per frame.
+
+class LDPC_EarlyStop
+{ public:
+   uint8_t  MinIter;                // never give up before this many iterations
+   uint8_t  MaxRepeat;              // give up when the hard decisions repeated an earlier pattern that many times
+   uint8_t  MaxFailed;              // give up after MinIter iterations when still more checks fail than this
+
+   uint8_t  Iter;                   // iterations so far
+   uint8_t  Repeat;                 // how many times the hard decisions repeated
+   uint32_t Sign[2];                // signatures of the hard decisions after the last two iterations
+
+  public:
+   LDPC_EarlyStop() { MinIter=8; MaxRepeat=4; MaxFailed=16; Start(); }
+
+   void Start(void) { Iter=0; Repeat=0; Sign[0]=0; Sign[1]=0; }
+
+   static uint32_t Signature(const uint32_t *Word, uint8_t Words=7) // short hash of the hard decisions
+   { uint32_t Sign=0;
+     for(uint8_t Idx=0; Idx<Words; Idx++)
+     { Sign = (Sign<<5) | (Sign>>27); Sign ^= Word[Idx]; }
+     return Sign; }
+
+   template <class LDPC_Dec>
+    bool Stop(uint8_t Count, const LDPC_Dec &Decoder)     // call after every iteration with what ProcessChecks() returned
+   { uint32_t Word[7]; Word[6]=0;
+     Decoder.Output(Word);
+     return Stop(Count, Signature(Word)); }
+
+   bool Stop(uint8_t Count, uint32_t HardSign)           // returns true when not worth to continue
+   { Iter++;
+     if( (HardSign==Sign[0]) || (HardSign==Sign[1]) ) Repeat++;
+     Sign[1]=Sign[0]; Sign[0]=HardSign;
+     if(Iter<MinIter) return 0;
+     if(Count>MaxFailed) return 1;                       // far from any codeword
+     if(Repeat>=MaxRepeat) return 1;                     // stuck on the same (wrong) bits
+     return 0; }
+
+} ;
+
 template <class Float=float>
  class LDPC_FloatDecoder
 { public:
@@ -340,60 +584,65 @@ template <class Float=float>
 } ;
 
 #ifdef WITH_PPM
-template <class Float>
+
+extern const uint16_t (&LDPC_ParityCheckIndex_n354k160)[194][12]; // derived from LDPC_ParityCheck_n354k160 at compile time
+
+template <class Float> struct OGN_PPM_Accum          { typedef Float   Type; } ; // wider type for sums
+template <>            struct OGN_PPM_Accum<int16_t> { typedef int32_t Type; } ;
+
+// Decoder for the long-range PPM mode: 64-ary PPM symbols carry 6 bits of the n354k160 Gallager code.
+// The demodulator gives the log-likelihood of every pulse position in every slot, the decoder iterates between
+// the symbol demapper (max-log, with the other bits of the symbol as a-priori from the LDPC code)
+// and the layered min-sum LDPC decoder, thus the symbol and bit information is exchanged as in a turbo decoder.
+// Float=float for the host, Float=int16_t with Metric=int8_t is the fixed-point version for the MCU (about 6.5KB RAM).
+
+template <class Float=float, class Metric=Float>
  class OGN_PPM_Decoder
 { public:
    static const int DataBits = 32*5;                      // 5 words = 160 data bits = OGN packet
    static const int ParityBits = 194;                     // 194 parity bits (Gallager code)
    static const int CodeBits = DataBits+ParityBits;       // 354 total bits per Gallager code block
+   static const int CodeWords = (CodeBits+31)/32;         // 12 32-bit words
    static const int BitsPerSymbol = 6;                    // 6 bits per symbol for PPM modulation
    static const int PulsesPerSlot = 1<<BitsPerSymbol;     // 64 (possible) pulses per time slot = 1 symbol = 6 bits
    static const int CodeSymbols = CodeBits/BitsPerSymbol; // 59 time slots to form complete packet
 
-   LDPC_FloatDecoder<Float> LDPC_Decoder;                 // inner LDPC code decoder
+   typedef typename OGN_PPM_Accum<Float>::Type Accum;
+   static const bool Fixed = std::numeric_limits<Float>::is_integer;
 
-   Float InpSymb[CodeSymbols][PulsesPerSlot];             // input from the demodulator
-   Float ExtSymb[CodeSymbols][PulsesPerSlot];             // output from the LDPC decoder
-   Float OutSymb[CodeSymbols][PulsesPerSlot];             // input x extrinsic inf.
+   Metric   InpSymb[CodeSymbols][PulsesPerSlot];          // input from the demodulator: log-likelihood of every pulse position
+   Float    ChanBit[CodeBits];                            // bits from the demapper (extrinsic w.r.t. the LDPC code)
+   Float    OutBit[CodeBits];                             // a-posteriori bits: ChanBit + check-to-bit messages
+
+   Float    CheckMin[ParityBits];                         // layered min-sum state: smallest amplitude among the bits of the check
+   Float    CheckMin2[ParityBits];                        // 2nd smallest
+   uint8_t  CheckMinBit[ParityBits];                      // which bit (within the check) has the smallest amplitude
+   uint16_t CheckWord[ParityBits];                        // hard decisions of the bit-to-check messages (row weight is up to 10)
 
   public:
-   OGN_PPM_Decoder()
-   { LDPC_Decoder.Configure(CodeBits, ParityBits, (uint32_t *)LDPC_ParityCheck_n354k160);
-     Clear(); }
+   OGN_PPM_Decoder() { Clear(); }
+
+   static Float Limit(Accum Value)                        // saturate for the fixed-point version
+   { if(!Fixed) return Value;
+     if(Value> 32767) return  32767;
+     if(Value<-32767) return -32767;
+     return Value; }
+
+   static Metric LimitMetric(Accum Value)
+   { if(!Fixed) return Value;
+     if(Value> 127) return  127;
+     if(Value<-127) return -127;
+     return Value; }
 
    void Clear(void)
    { for(int Symb=0; Symb<CodeSymbols; Symb++)
-     { Float Ext=1.0/PulsesPerSlot;
        for(int Pulse=0; Pulse<PulsesPerSlot; Pulse++)
-       { InpSymb[Symb][Pulse]=0; ExtSymb[Symb][Pulse]=Ext; OutSymb[Symb][Pulse]=0; }
-     }
+         InpSymb[Symb][Pulse]=0;
    }
 
-   void addSymbol(unsigned int Slot, unsigned int Symbol, Float Power=1.0)
-   { if( (Slot>=CodeSymbols) || (Symbol>=PulsesPerSlot) ) return;
-     InpSymb[Slot][Symbol]+=Power; }
-
-   int Process(int Loops=48)
-   { LDPC_Decoder.Clear();
-
-     for(int Symb=0; Symb<CodeSymbols; Symb++)
-     { for(int Pulse=0; Pulse<PulsesPerSlot; Pulse++)
-       { Float Pwr=InpSymb[Symb][Pulse]*ExtSymb[Symb][Pulse];
-         if(Pwr==0) continue;
-         Pwr=Pwr*Pwr;
-         int Bin=Binary(Pulse);
-         int Idx=Symb;
-         for(int Bit=0; Bit<BitsPerSymbol; Bit++, Idx+=CodeSymbols)
-         { LDPC_Decoder.addInput(Idx, (Bin&1) ? +Pwr:-Pwr);
-           Bin>>=1; }
-       }
-     }
-     int CheckErr=0;
-     for( int Loop=0; Loop<Loops; Loop++)
-     { CheckErr=LDPC_Decoder.ProcessChecks();
-       printf("%3d: OGN_PPM_Decoder.Process() => %3d\n", Loop, CheckErr);
-       if(CheckErr==0) break; }
-     return CheckErr; }
+   void addSymbol(unsigned int Slot, unsigned int Pulse, Metric LogLike) // add the log-likelihood of a pulse (relative to no pulse)
+   { if( (Slot>=CodeSymbols) || (Pulse>=PulsesPerSlot) ) return;
+     InpSymb[Slot][Pulse] = LimitMetric((Accum)InpSymb[Slot][Pulse]+LogLike); }
 
    static uint8_t Gray(uint8_t Binary) { return Binary ^ (Binary>>1); }
 
@@ -403,20 +652,91 @@ template <class Float>
      Gray = Gray ^ (Gray >> 1);
      return Gray; }
 
-   void NormExtSymb(Float Norm=1.0)
-   { for(int Symb=0; Symb<CodeSymbols; Symb++)
-     { NormExtSymb(Symb, Norm); }
+   void Demap(int Symb)                                   // new ChanBit's for the bits of this symbol, OutBit's follow
+   { Float Apriori[BitsPerSymbol];                        // what the LDPC code says about the bits: extrinsic w.r.t. the channel
+     int Idx=Symb;
+     for(int Bit=0; Bit<BitsPerSymbol; Bit++, Idx+=CodeSymbols)
+       Apriori[Bit] = Limit((Accum)OutBit[Idx]-ChanBit[Idx]);
+     Accum Max0[BitsPerSymbol], Max1[BitsPerSymbol];
+     for(int Bit=0; Bit<BitsPerSymbol; Bit++)
+     { Max0[Bit]=(-(Accum)0x3FFFFFFF); Max1[Bit]=Max0[Bit]; }
+     for(int Pulse=0; Pulse<PulsesPerSlot; Pulse++)
+     { uint8_t Bin=Binary(Pulse);
+       Accum Metr = (Accum)InpSymb[Symb][Pulse]*2;       // symbol metric: channel + half of the a-priori of every bit
+       for(int Bit=0; Bit<BitsPerSymbol; Bit++)
+         Metr += ((Bin>>Bit)&1) ? Apriori[Bit]:-Apriori[Bit];
+       for(int Bit=0; Bit<BitsPerSymbol; Bit++)
+       { Accum *Max = ((Bin>>Bit)&1) ? Max1:Max0;
+         if(Metr>Max[Bit]) Max[Bit]=Metr; }
+     }
+     Idx=Symb;
+     for(int Bit=0; Bit<BitsPerSymbol; Bit++, Idx+=CodeSymbols)
+     { Float Chan = Limit((Max1[Bit]-Max0[Bit])/2-Apriori[Bit]); // max-log: exclude the a-priori of this bit
+       OutBit[Idx] = Limit((Accum)OutBit[Idx]+Chan-ChanBit[Idx]);
+       ChanBit[Idx] = Chan; }
    }
 
-   void NormExtSymp(int Symb, Float Norm=1.0)
-   { Float Sum=0;
-     for(int Pulse=0; Pulse<PulsesPerSlot; Pulse++)
-     { Sum+=ExtSymb[Symb][Pulse]; }
-     Sum=Norm/Sum;
-     for(int Pulse=0; Pulse<PulsesPerSlot; Pulse++)
-     { ExtSymb[Symb][Pulse]*=Sum; }    
+   void Output(uint32_t Data[CodeWords]) const
+   { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=0;
+     for(int Bit=0; Bit<CodeBits; Bit++)
+     { if(OutBit[Bit]>0) Word|=Mask;
+       Mask<<=1; if(Mask==0) { Data[Idx++]=Word; Word=0; Mask=1; }
+     } if(Mask>1) Data[Idx++]=Word;
    }
 
+   uint8_t CountFailedChecks(void) const
+   { uint32_t Data[CodeWords]; Output(Data);
+     return LDPC_Check_n354k160(Data); }
+
+   void ProcessCheck(uint8_t Row)                         // same as LDPC_LayeredDecoder::ProcessCheck() with normalized (x3/4) min-sum
+   { const uint16_t *CheckIndex = LDPC_ParityCheckIndex_n354k160[Row];
+     uint8_t CheckWeight = *CheckIndex++;
+     Float OldMin=CheckMin[Row]; Float OldMin2=CheckMin2[Row]; uint8_t OldMinBit=CheckMinBit[Row];
+     uint16_t OldWord=CheckWord[Row]; uint8_t OldFails=Count1s(OldWord)&1;
+     Float MinAmpl=0; uint8_t MinBit=0; Float MinAmpl2=0;
+     uint16_t Word=0; uint16_t Mask=1;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)           // remove the old check-to-bit message and find the two smallest bit-to-check
+     { uint16_t BitIdx=CheckIndex[Bit];
+       Float Old = Bit==OldMinBit ? OldMin2:OldMin;
+       if( ((OldWord&Mask)!=0) == (OldFails!=0) ) Old=(-Old);
+       Float Ampl=Limit((Accum)OutBit[BitIdx]-Old);
+       OutBit[BitIdx]=Ampl;
+       if(Ampl>0) Word|=Mask;
+       Mask<<=1;
+       if(Ampl<0) Ampl=(-Ampl);
+       if( (Bit==0) || (Ampl<MinAmpl) ) { MinAmpl2=MinAmpl; MinAmpl=Ampl; MinBit=Bit; }
+       else if( (Bit==1) || (Ampl<MinAmpl2) ) { MinAmpl2=Ampl; }
+     }
+     MinAmpl=MinAmpl*3/4; MinAmpl2=MinAmpl2*3/4;
+     uint8_t CheckFails = Count1s(Word)&1;
+     Mask=1;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)           // add the new check-to-bit message
+     { uint16_t BitIdx=CheckIndex[Bit];
+       Float Ampl = Bit==MinBit ? MinAmpl2 : MinAmpl;
+       if( ((Word&Mask)!=0) == (CheckFails!=0) ) Ampl=(-Ampl);
+       OutBit[BitIdx] = Limit((Accum)OutBit[BitIdx]+Ampl);
+       Mask<<=1; }
+     CheckMin[Row]=MinAmpl; CheckMin2[Row]=MinAmpl2; CheckMinBit[Row]=MinBit; CheckWord[Row]=Word; }
+
+   // Loops: demapper+LDPC rounds, returns the number of failed parity checks: zero means a correct codeword
+   int Process(int Loops=24, uint8_t *LoopsUsed=0)
+   { for(int Bit=0; Bit<CodeBits; Bit++)
+     { ChanBit[Bit]=0; OutBit[Bit]=0; }
+     for(int Row=0; Row<ParityBits; Row++)
+     { CheckMin[Row]=0; CheckMin2[Row]=0; CheckMinBit[Row]=0; CheckWord[Row]=0; }
+     int CheckErr=0; int Loop;
+     for(Loop=0; Loop<Loops; Loop++)
+     { for(int Symb=0; Symb<CodeSymbols; Symb++)         // symbols => bits, with the feedback from the LDPC code
+         Demap(Symb);
+       CheckErr=CountFailedChecks();
+       if(CheckErr==0) break;
+       for(int Row=0; Row<ParityBits; Row++)              // one layered LDPC iteration: bits => checks => bits
+         ProcessCheck(Row);
+     }
+     if(CheckErr) CheckErr=CountFailedChecks();
+     if(LoopsUsed) *LoopsUsed=Loop;
+     return CheckErr; }
+
 } ;
 #endif // WITH_PPM
 
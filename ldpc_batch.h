@@ -0,0 +1,178 @@
+#ifndef __LDPC_BATCH_H__
+#define __LDPC_BATCH_H__
+
+// Host-only (ground station) batch decoder for the OGN n208k160 code:
+// runs the same algorithm as LDPC_Decoder but on several codewords at once, one codeword per SIMD lane.
+// Uses the GCC vector extensions: the compiler maps them onto SSE2/AVX2/NEON or scalar code, depending on -m flags
+// thus compile with -msse2 or -mavx2 (or -march=native) to get the speed-up (and -Wno-psabi to silence the ABI notes).
+// The results are bit-exact with LDPC_Decoder: same int16 arithmetic, same rounding and same overflow behavior.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "ldpc.h"
+
+template <int Lanes=16>                                    // 8, 16 or 32 codewords processed in parallel
+ class LDPC_BatchDecoder
+{ public:
+   const static uint8_t UserBits   = 160;                 // 5 32-bit bits = 20 bytes
+   const static uint8_t UserWords  = UserBits/32;
+   const static uint8_t ParityBits =  48;                 // 6 bytes (total packet is 26 bytes)
+   const static uint8_t CodeBits   = UserBits+ParityBits; // 160+48 = 208 code bits = 26 bytes
+   const static uint8_t CodeBytes  = (CodeBits+ 7)/ 8;    //
+   const static uint8_t CodeWords  = (CodeBits+31)/32;    //
+
+#if defined(__AVX512BW__)
+   const static int VectLanes = 32;                       // lanes in a native SIMD register
+#elif defined(__AVX2__)
+   const static int VectLanes = 16;
+#else
+   const static int VectLanes =  8;                       // SSE2, NEON or scalar fallback
+#endif
+   const static int Parts = Lanes>VectLanes ? Lanes/VectLanes:1; // vectors wider than native are handled as several parts
+   const static int PartLanes = Lanes/Parts;
+
+   typedef int16_t LLR __attribute__ ((vector_size (2*PartLanes))); // one bit of the codewords in a part
+
+  public:
+
+   LLR InpBit[Parts][CodeBits]; // a-priori bits
+   LLR ExtBit[Parts][CodeBits]; // extrinsic inf.
+   LLR OutBit[Parts][CodeBits]; // a-posteriori bits
+
+   static       int16_t &Elem(      LLR Bits[Parts][CodeBits], int Bit, int Lane) // single bit of a single codeword
+   { return ((      int16_t *)&Bits[Lane/PartLanes][Bit])[Lane%PartLanes]; }
+   static const int16_t &Elem(const LLR Bits[Parts][CodeBits], int Bit, int Lane)
+   { return ((const int16_t *)&Bits[Lane/PartLanes][Bit])[Lane%PartLanes]; }
+
+  private:
+
+   static LLR Splat(int16_t Value) { LLR Zero = { 0 }; return Zero+Value; } // same value in all lanes
+
+   static LLR Select(LLR Mask, LLR A, LLR B) { return (Mask&A) | (~Mask&B); } // Mask must be all 0's or all 1's per lane
+
+  public:
+
+   void Clear(void)                                       // all lanes as if received zeros and all erased
+   { LLR Zero = Splat(0);
+     for(int Part=0; Part<Parts; Part++)
+       for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+       { InpBit[Part][Bit]=Zero; ExtBit[Part][Bit]=Zero; OutBit[Part][Bit]=Zero; }
+   }
+
+   void Input(int Lane, const uint8_t *Data, const uint8_t *Err)
+   { uint8_t Mask=1; uint8_t Idx=0; uint8_t DataByte=0; uint8_t ErrByte=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(Mask==1) { DataByte=Data[Idx];  ErrByte=Err[Idx]; }
+       int16_t Inp;
+       if(ErrByte&Mask) Inp=0;
+                   else Inp=(DataByte&Mask) ? +128:-128;
+       Elem(OutBit, Bit, Lane) = Elem(InpBit, Bit, Lane) = Inp; Elem(ExtBit, Bit, Lane)=0;
+       Mask<<=1; if(Mask==0) { Idx++; Mask=1; }
+     }
+   }
+
+   void Input(int Lane, const uint32_t Data[CodeWords])
+   { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=Data[Idx];
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { Elem(OutBit, Bit, Lane) = Elem(InpBit, Bit, Lane) = (Word&Mask) ? +128:-128;
+       Elem(ExtBit, Bit, Lane)=0;
+       Mask<<=1; if(Mask==0) { Word=Data[++Idx]; Mask=1; }
+     }
+   }
+
+   void Input(int Lane, const float *Data, float RefAmpl=1.0)
+   { for(int Bit=0; Bit<CodeBits; Bit++)
+     { int Inp = floor(128*Data[Bit^7]/RefAmpl+0.5);
+       if(Inp>32767) Inp=32767; else if(Inp<(-32767)) Inp=(-32767);
+       Elem(OutBit, Bit, Lane) = Elem(InpBit, Bit, Lane) = Inp;
+       Elem(ExtBit, Bit, Lane)=0; }
+   }
+
+   void Output(int Lane, uint32_t Data[CodeWords]) const
+   { uint32_t Mask=1; uint8_t Idx=0; uint32_t Word=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(Elem(OutBit, Bit, Lane)>0) Word|=Mask;
+       Mask<<=1; if(Mask==0) { Data[Idx++]=Word; Word=0; Mask=1; }
+     } if(Mask>1) Data[Idx++]=Word;
+   }
+
+   void Output(int Lane, uint8_t Data[CodeBytes]) const
+   { uint8_t Mask=1; uint8_t Idx=0; uint8_t Byte=0;
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+     { if(Elem(OutBit, Bit, Lane)>0) Byte|=Mask;
+       Mask<<=1; if(Mask==0) { Data[Idx++]=Byte; Byte=0; Mask=1; }
+     } if(Mask>1) Data[Idx++]=Byte;
+   }
+
+   // one iteration on all lanes: Count[Lane] gets what LDPC_Decoder::ProcessChecks() would return for that codeword,
+   // lanes with zero count are not changed (like the scalar decoder which returns without an update).
+   // Returns the number of lanes which still fail.
+   int ProcessChecks(int8_t Count[Lanes])
+   { int Failed=0;
+     for(int Part=0; Part<Parts; Part++)
+       Failed+=ProcessChecks(Part, Count+Part*PartLanes);
+     return Failed; }
+
+   int ProcessChecks(int Part, int8_t Count[PartLanes])
+   { LLR Zero = Splat(0);
+     LLR *Ext=ExtBit[Part];
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+       Ext[Bit]=Zero;
+     LLR Fails=Zero;                                      // count failed checks per lane
+     for(uint8_t Row=0; Row<ParityBits; Row++)
+       Fails -= ProcessCheck(Part, Row);
+     LLR Update = Fails!=Zero;                            // lanes to be updated
+     const LLR *Inp=InpBit[Part]; LLR *Out=OutBit[Part];
+     for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+       Out[Bit] = Select(Update, Inp[Bit] + (Ext[Bit]>>1), Out[Bit]);
+     int Failed=0;
+     for(int Lane=0; Lane<PartLanes; Lane++)
+     { Count[Lane]=((const int16_t *)&Fails)[Lane]; if(Count[Lane]) Failed++; }
+     return Failed; }
+
+   LLR ProcessCheck(int Part, uint8_t Row)               // returns -1 for lanes where the check fails (or is on a zero amplitude)
+   { LLR MinAmpl=Splat(32767); LLR MinBit=Splat(0); LLR MinAmpl2=MinAmpl;
+     LLR Zero=Splat(0);
+     LLR Parity=Zero;
+     LLR BitVect=Zero;                                    // Bit in all lanes
+     const LLR *Out=OutBit[Part]; LLR *Ext=ExtBit[Part];
+     const uint8_t *CheckIndex = LDPC_ParityCheckIndex_n208k160[Row];
+     uint8_t CheckWeight = *CheckIndex++;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)
+     { uint8_t BitIdx=CheckIndex[Bit];
+       LLR Ampl=Out[BitIdx];
+       Parity ^= Ampl>Zero;
+       Ampl = Select(Ampl<Zero, -Ampl, Ampl);
+       LLR Less  = Ampl<MinAmpl;
+       LLR Less2 = Ampl<MinAmpl2;
+       MinAmpl2 = Select(Less, MinAmpl, Select(Less2, Ampl, MinAmpl2));
+       MinBit   = Select(Less, BitVect, MinBit);
+       MinAmpl  = Select(Less, Ampl, MinAmpl);
+       BitVect += 1; }
+     BitVect=Zero;
+     for(uint8_t Bit=0; Bit<CheckWeight; Bit++)
+     { uint8_t BitIdx=CheckIndex[Bit];
+       LLR Ampl = Select(MinBit==BitVect, MinAmpl2, MinAmpl);
+       BitVect += 1;
+       Ampl = Select(Parity, -Ampl, Ampl);
+       Ext[BitIdx] += Select(Out[BitIdx]>Zero, Ampl, -Ampl); }
+     return Parity | (MinAmpl==Zero); }
+
+   // decode all lanes: Check[Lane] gets the number of failed checks at the end, zero means the codeword is correct
+   int Decode(int8_t Check[Lanes], uint8_t MaxIter=32)
+   { int Failed=0;
+     for(int Part=0; Part<Parts; Part++)                  // parts are independent: each stops when all its lanes are correct
+     { int8_t *PartCheck = Check+Part*PartLanes;
+       for(int Lane=0; Lane<PartLanes; Lane++) PartCheck[Lane]=0;
+       int PartFailed=0;
+       for(uint8_t Iter=0; Iter<MaxIter; Iter++)
+       { PartFailed=ProcessChecks(Part, PartCheck);
+         if(PartFailed==0) break; }
+       Failed+=PartFailed; }
+     return Failed; }
+
+} ;
+
+#endif // __LDPC_BATCH_H__
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ldpc.h"
+#include "ldpc_batch.h"
+#include "hosttest.h"
+
+// check LDPC_BatchDecoder bit-for-bit against LDPC_Decoder and measure the throughput
+// compile e.g.: g++ -O3 -march=native -Wno-psabi ldpc_batch_test.cc ldpc.cpp bitcount.cpp -o ldpc_batch_test
+
+static void RandomPacket(float *Soft, double Sigma)             // random codeword through an AWGN channel
+{ uint32_t Codeword[7];
+  for(int Idx=0; Idx<5; Idx++)
+    Codeword[Idx] = ((uint32_t)random()<<16) ^ random();
+  LDPC_Encode(Codeword);
+  for(int Bit=0; Bit<208; Bit++)
+  { double Ampl = ((Codeword[Bit>>5]>>(Bit&31))&1) ? +1.0:-1.0;
+    Soft[Bit^7] = Ampl + Sigma*GaussNoise(); }
+}
+
+static LDPC_Decoder Scalar;
+
+template <int Lanes>
+ int Test(const float *Soft, int Packets, int MaxIter, double &ScalarTime, double &BatchTime) // returns number of mismatches
+{ static LDPC_BatchDecoder<Lanes> Batch;
+  int8_t *ScalarCheck = new int8_t[Packets];
+  int16_t *ScalarOut  = new int16_t[Packets*208];
+  clock_t Start=clock();
+  for(int Pkt=0; Pkt<Packets; Pkt++)
+  { Scalar.Input(Soft+Pkt*208);
+    int8_t Check=0;
+    for(int Iter=0; Iter<MaxIter; Iter++)
+    { Check=Scalar.ProcessChecks(); if(Check==0) break; }
+    ScalarCheck[Pkt]=Check;
+    for(int Bit=0; Bit<208; Bit++) ScalarOut[Pkt*208+Bit]=Scalar.OutBit[Bit]; }
+  ScalarTime = (double)(clock()-Start)/CLOCKS_PER_SEC;
+  int Errors=0;
+  int8_t Check[Lanes];
+  int16_t *BatchOut = new int16_t[Packets*208];
+  int8_t *BatchCheck = new int8_t[Packets];
+  Start=clock();
+  for(int Pkt=0; Pkt+Lanes<=Packets; Pkt+=Lanes)
+  { for(int Lane=0; Lane<Lanes; Lane++)
+      Batch.Input(Lane, Soft+(Pkt+Lane)*208);
+    Batch.Decode(Check, MaxIter);
+    for(int Lane=0; Lane<Lanes; Lane++)
+    { BatchCheck[Pkt+Lane]=Check[Lane];
+      for(int Bit=0; Bit<208; Bit++) BatchOut[(Pkt+Lane)*208+Bit]=Batch.Elem(Batch.OutBit, Bit, Lane); }
+  }
+  BatchTime = (double)(clock()-Start)/CLOCKS_PER_SEC;
+  for(int Pkt=0; Pkt<Packets; Pkt++)
+  { bool Diff = BatchCheck[Pkt]!=ScalarCheck[Pkt];
+    for(int Bit=0; Bit<208; Bit++)
+      if(BatchOut[Pkt*208+Bit]!=ScalarOut[Pkt*208+Bit]) Diff=1;
+    if(Diff) Errors++; }
+  delete [] ScalarCheck; delete [] ScalarOut; delete [] BatchOut; delete [] BatchCheck;
+  return Errors; }
+
+int main(int argc, char *argv[])
+{ int Packets = 16384;
+  if(argc>1) Packets=atoi(argv[1]);
+  Packets&=~31;
+
+  const double Rate = 160.0/208;
+  float *Soft = new float[Packets*208];
+  int TotalErrors=0;
+
+  for(double EbN0=3.0; EbN0<=6.01; EbN0+=1.0)                  // [dB]
+  { double Sigma = sqrt(1.0/(2*Rate*pow(10.0, 0.1*EbN0)));
+    srandom(12345);
+    for(int Pkt=0; Pkt<Packets; Pkt++)
+      RandomPacket(Soft+Pkt*208, Sigma);
+    double ScalarTime, BatchTime; int Errors;
+    printf("Eb/N0=%3.1fdB:", EbN0);
+    Errors=Test< 8>(Soft, Packets, 32, ScalarTime, BatchTime); TotalErrors+=Errors;
+    printf(" scalar %6.0f pkt/s,  8 lanes %6.0f pkt/s (%d diff)", Packets/ScalarTime, Packets/BatchTime, Errors);
+    Errors=Test<16>(Soft, Packets, 32, ScalarTime, BatchTime); TotalErrors+=Errors;
+    printf(", 16 lanes %6.0f pkt/s (%d diff)", Packets/BatchTime, Errors);
+    Errors=Test<32>(Soft, Packets, 32, ScalarTime, BatchTime); TotalErrors+=Errors;
+    printf(", 32 lanes %6.0f pkt/s (%d diff)\n", Packets/BatchTime, Errors); }
+
+  delete [] Soft;
+  printf("%s\n", TotalErrors ? "FAILED: batch and scalar decoders differ":"OK: batch and scalar decoders agree bit-for-bit");
+  return TotalErrors!=0; }
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ldpc.h"
+#include "ldpc_tables.h"
+
+// prove the generator and parity-check matrices of the OGN codes are consistent: G*H^T = 0
+// and that the decoder tables derived at compile time (ldpc_tables.h) describe the same parity-check matrix
+// and that the parity patch for header changes (relayed packets) agrees with the encoder
+// compile: g++ -std=gnu++14 -DWITH_PPM ldpc_code_test.cc ldpc.cpp bitcount.cpp -o ldpc_code_test
+
+typedef void (*Encoder)(const uint32_t *Data, uint32_t *Parity);
+
+static int Parity(const uint32_t *Codeword, const uint32_t *Check, int Words) // one row of G times one row of H
+{ uint32_t Sum=0;
+  for(int Idx=0; Idx<Words; Idx++)
+    Sum^=Codeword[Idx]&Check[Idx];
+  return Count1s(Sum)&1; }
+
+// every row of G is the codeword of a single user bit: [unit vector | parity bits from the encoder]
+static int TestGHt(const char *Name, Encoder Encode, int ParityBits, const uint32_t *Check, int Words) // returns number of non-zero elements of G*H^T
+{ int Errors=0;
+  for(int Bit=0; Bit<160; Bit++)
+  { uint32_t Codeword[12];
+    memset(Codeword, 0, sizeof(Codeword));
+    Codeword[Bit>>5] = (uint32_t)1<<(Bit&31);
+    Encode(Codeword, Codeword+5);
+    for(int Row=0; Row<ParityBits; Row++)
+      Errors+=Parity(Codeword, Check+Row*Words, Words); }
+  printf("%s: G*H^T has %d non-zero elements out of %d\n", Name, Errors, 160*ParityBits);
+  return Errors; }
+
+template <int Rows, int MaxWeight, class Idx, int Words>
+ static int TestIndex(const char *Name, const LDPC_IndexTable<Rows, MaxWeight, Idx> &Table, const uint32_t (&Check)[Rows][Words]) // returns number of rows which differ
+{ int Errors=0;
+  for(int Row=0; Row<Rows; Row++)
+  { uint32_t Bits[Words];
+    memset(Bits, 0, sizeof(Bits));
+    int Weight=Table.Index[Row][0];
+    for(int Bit=1; Bit<=Weight; Bit++)
+    { int BitIdx=Table.Index[Row][Bit];
+      Bits[BitIdx>>5] |= (uint32_t)1<<(BitIdx&31); }
+    if(memcmp(Bits, Check[Row], sizeof(Bits))) Errors++; }
+  printf("%s: %d rows of the check index differ from the parity-check matrix\n", Name, Errors);
+  return Errors; }
+
+int main(int argc, char *argv[])
+{ int Errors=0;
+
+  Errors+=TestGHt("n208k160", LDPC_Encode_Gen, 48, LDPC_ParityCheck_n208k160[0], 7);
+  Errors+=TestIndex("n208k160", LDPC_CheckIndex<24>(LDPC_ParityCheck_n208k160, 208), LDPC_ParityCheck_n208k160);
+  for(int Row=0; Row<48; Row++)                                      // the table used by the decoders
+    if(memcmp(LDPC_ParityCheckIndex_n208k160[Row], LDPC_CheckIndex<24>(LDPC_ParityCheck_n208k160, 208).Index[Row], 24)) Errors++;
+
+  LDPC_MaskTable<4, 7> Mask = LDPC_BitWeightMask<208, 3, 4>(LDPC_ParityCheck_n208k160);
+  int MaskErr=0; int Total=0;
+  for(int Bit=0; Bit<208; Bit++)                                     // every bit is in exactly one group
+  { int Groups=0; int Weight=0;
+    for(int Group=0; Group<4; Group++)
+      if((Mask.Mask[Group][Bit>>5]>>(Bit&31))&1) { Groups++; Weight=3+Group; }
+    int Count=0;
+    for(int Row=0; Row<48; Row++)
+      Count+=(LDPC_ParityCheck_n208k160[Row][Bit>>5]>>(Bit&31))&1;
+    if( (Groups!=1) || (Weight!=Count) ) MaskErr++;
+    Total+=Count; }
+  printf("n208k160: %d bits with wrong weight group, %d ones in H\n", MaskErr, Total);
+  Errors+=MaskErr;
+
+  int PatchErr=0;                                                    // parity patched for a change in the header = parity encoded again
+  srandom(1234);
+  for(int Test=0; Test<10000; Test++)
+  { uint32_t Codeword[7], Encoded[2];
+    for(int Idx=0; Idx<5; Idx++) Codeword[Idx]=random()^(random()<<16);
+    LDPC_Encode_Gen(Codeword, Codeword+5);
+    uint32_t Diff = Test<32 ? (uint32_t)1<<Test : random()^(random()<<16);
+    Codeword[0]^=Diff;
+    LDPC_PatchHeader(Codeword+5, Diff);
+    LDPC_Encode_Gen(Codeword, Encoded);
+    if( (Codeword[5]!=Encoded[0]) || ((Codeword[6]^Encoded[1])&0xFFFF) ) PatchErr++; }
+  printf("n208k160: %d header changes with wrong patched parity\n", PatchErr);
+  Errors+=PatchErr;
+
+#ifdef WITH_PPM
+  Errors+=TestGHt("n354k160", LDPC_Encode_n354k160, 194, LDPC_ParityCheck_n354k160[0], 12);
+  Errors+=TestIndex("n354k160", LDPC_CheckIndex<64, uint16_t>(LDPC_ParityCheck_n354k160, 354), LDPC_ParityCheck_n354k160);
+#endif
+
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ldpc.h"
+#include "hosttest.h"
+
+// check the table-driven LDPC encoders bit-for-bit against the generator-row encoder and measure the encode time
+// compile: g++ -O2 -DWITH_LDPC_ENC_NIBBLE -DWITH_LDPC_ENC_BYTE ldpc_encode_test.cc ldpc.cpp bitcount.cpp -o ldpc_encode_test
+
+typedef void (*Encoder)(const uint32_t *Data, uint32_t *Parity);
+
+static int Verify(Encoder Encode, const uint32_t *Data, int Packets)   // returns number of packets with a different parity
+{ int Errors=0;
+  for(int Pkt=0; Pkt<Packets; Pkt++, Data+=5)
+  { uint32_t Ref[2], Parity[2];
+    LDPC_Encode_Gen(Data, Ref);
+    Encode(Data, Parity);
+    if( (Ref[0]!=Parity[0]) || (Ref[1]!=Parity[1]) ) Errors++; }
+  return Errors; }
+
+static double Measure(Encoder Encode, const uint32_t *Data, int Packets) // [cycles/packet]
+{ uint32_t Sum=0;
+  uint64_t Start=Cycles();
+  for(int Pkt=0; Pkt<Packets; Pkt++)
+  { uint32_t Parity[2];
+    Encode(Data+5*Pkt, Parity);
+    Sum^=Parity[0]^Parity[1]; }
+  uint64_t Time=Cycles()-Start;
+  if(Sum==0x12345678) printf("\n");                            // keep the compiler from removing the loop
+  return (double)Time/Packets; }
+
+int main(int argc, char *argv[])
+{ int Packets = 100000;
+  if(argc>1) Packets=atoi(argv[1]);
+  uint32_t *Data = new uint32_t[5*Packets];
+  srandom(12345);
+  for(int Idx=0; Idx<5*Packets; Idx++)
+    Data[Idx] = ((uint32_t)random()<<16) ^ random();
+  for(int Bit=0; Bit<160 && Bit<Packets; Bit++)               // single-bit patterns as well
+  { for(int Idx=0; Idx<5; Idx++) Data[5*Bit+Idx]=0;
+    Data[5*Bit+(Bit>>5)] = (uint32_t)1<<(Bit&31); }
+
+  int Errors=0;
+  printf("Generator rows: %7.1f cycles/packet\n", Measure(LDPC_Encode_Gen, Data, Packets));
+#ifdef WITH_LDPC_ENC_NIBBLE
+  { int Err=Verify(LDPC_Encode_Nibble, Data, Packets); Errors+=Err;
+    printf("Nibble tables:  %7.1f cycles/packet, %d/%d packets differ\n", Measure(LDPC_Encode_Nibble, Data, Packets), Err, Packets); }
+#endif
+#ifdef WITH_LDPC_ENC_BYTE
+  { int Err=Verify(LDPC_Encode_Byte, Data, Packets); Errors+=Err;
+    printf("Byte tables:    %7.1f cycles/packet, %d/%d packets differ\n", Measure(LDPC_Encode_Byte, Data, Packets), Err, Packets); }
+#endif
+  delete [] Data;
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
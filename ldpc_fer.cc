@@ -0,0 +1,341 @@
+// Monte-Carlo frame/bit error rate of the OGN Gallager code n208k160 for the decoders in ldpc.h
+//
+// compile: g++ -O3 -std=gnu++14 -pthread -Wno-psabi ldpc_fer.cc ldpc.cpp bitcount.cpp format.cpp intmath.cpp -o ldpc_fer
+// usage:   ldpc_fer [-c awgn|manch|noise|burst] [-n packets] [-t threads] [-s seed] [-i iterations] [-f from_dB] [-e to_dB] [-d step_dB]
+//                  [-x MinIter,MaxRepeat,MaxFailed] [-w NearWeight]
+//
+// Random OGN position packets are whitened and encoded with LDPC_Encode(), sent through the channel model:
+//  awgn:  BPSK with additive white gaussian noise, the decoders get the soft values
+//  manch: every bit is sent as a Manchester pair of chips, each chip with gaussian noise and a hard decision:
+//         equal chips are reported as erased, like the RF chip Manchester decoder does in the tracker
+//  noise: random bits, no erasures: a strong non-OGN frame (like FLARM); shows how many iterations are burnt on it
+//  burst: like manch, but every packet is hit by an interference burst of 8..24 bits where the chips are random
+// -x sets the LDPC_EarlyStop thresholds for the Flip+L8/ES decoder
+// -w sets the [1/16] weight of bits next to Manchester errors for the Flip+L8/W decoder (it uses early stop as well),
+//    the default 16 (no reduction) is the tracker value RFM_RxPktData::NearErrWeight
+// The packets are processed in blocks, each block with its own seed, thus the results do not depend
+// on the number of threads.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "ogn.h"
+#include "ldpc.h"
+
+class RandGen                                                   // xorshift64*: small, fast and good enough for noise
+{ public:
+   uint64_t State;
+
+  public:
+   RandGen(uint64_t Seed=1) { setSeed(Seed); }
+   void setSeed(uint64_t Seed) { State = Seed*0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL; if(State==0) State=1; }
+
+   uint64_t Next(void)
+   { State ^= State>>12; State ^= State<<25; State ^= State>>27;
+     return State*0x2545F4914F6CDD1DULL; }
+
+   uint32_t Word(void) { return Next()>>32; }
+
+   double Uniform(void) { return ((Next()>>11)+0.5)/9007199254740992.0; } // (0..1)
+
+   double Gauss(void)                                           // Box-Muller
+   { double R = sqrt(-2*log(Uniform()));
+     return R*cos(2*M_PI*Uniform()); }
+} ;
+
+static void RandomPacket(uint32_t *Codeword, RandGen &Rand)    // random OGN position packet + parity bits
+{ OGN_Packet Packet;
+  Packet.Clear();
+  Packet.Header.Address  = Rand.Word()&0x00FFFFFF;
+  Packet.Header.AddrType = Rand.Word()&3;
+  Packet.calcAddrParity();
+  Packet.Position.FixQuality = 1;
+  Packet.Position.FixMode    = 1;
+  Packet.Position.Time       = Rand.Word()%60;
+  Packet.EncodeLatitude ((int32_t)(Rand.Word()%(180*600000))-90*600000);   // [0.0001/60 deg]
+  Packet.EncodeLongitude((int32_t)(Rand.Word()%(360*600000))-180*600000);
+  Packet.EncodeAltitude(Rand.Word()%5000);                                  // [m]
+  Packet.EncodeDOP(Rand.Word()%50);
+  Packet.EncodeSpeed(Rand.Word()%1000);                                     // [0.1m/s]
+  Packet.EncodeHeading(Rand.Word()%3600);                                   // [0.1deg]
+  Packet.EncodeTurnRate((int16_t)(Rand.Word()%400)-200);                    // [0.1deg/s]
+  Packet.EncodeClimbRate((int16_t)(Rand.Word()%200)-100);                   // [0.1m/s]
+  Packet.Position.AcftType   = Rand.Word()&15;
+  Packet.Whiten();
+  memcpy(Codeword, Packet.Word(), 20);
+  LDPC_Encode(Codeword); }
+
+class Channel                                                   // what the receiver gets for one packet
+{ public:
+   float   Soft[208];                                           // soft values, on-air (MSB first) bit order, unit amplitude
+   uint8_t Data[26];                                            // hard bits
+   uint8_t Err[26];                                             // erased bits (Manchester errors)
+
+  public:
+   void AWGN(const uint32_t *Codeword, double Sigma, RandGen &Rand)
+   { memset(Data, 0, 26); memset(Err, 0, 26);
+     for(int Bit=0; Bit<208; Bit++)
+     { double Ampl = ((Codeword[Bit>>5]>>(Bit&31))&1) ? +1.0:-1.0;
+       Ampl += Sigma*Rand.Gauss();
+       Soft[Bit^7] = Ampl;
+       if(Ampl>0) Data[Bit>>3] |= 1<<(Bit&7); }
+   }
+
+   void Noise(RandGen &Rand)
+   { memset(Err, 0, 26);
+     for(int Byte=0; Byte<26; Byte++)
+       Data[Byte] = Rand.Word();
+     for(int Bit=0; Bit<208; Bit++)
+       Soft[Bit^7] = ((Data[Bit>>3]>>(Bit&7))&1) ? +1.0:-1.0; }
+
+   void Manchester(const uint32_t *Codeword, double Sigma, RandGen &Rand)
+   { memset(Data, 0, 26); memset(Err, 0, 26);
+     for(int Bit=0; Bit<208; Bit++)
+     { double Ampl = ((Codeword[Bit>>5]>>(Bit&31))&1) ? +1.0:-1.0;
+       bool Chip0 = ( Ampl+Sigma*Rand.Gauss())>0;              // the chip pair is (+A,-A) for 1 and (-A,+A) for 0
+       bool Chip1 = (-Ampl+Sigma*Rand.Gauss())>0;
+       float Value = 0;
+       if(Chip0!=Chip1) Value = Chip0 ? +1.0:-1.0;
+                   else Err[Bit>>3] |= 1<<(Bit&7);
+       if(Chip0) Data[Bit>>3] |= 1<<(Bit&7);
+       Soft[Bit^7] = Value; }
+   }
+
+   void Burst(const uint32_t *Codeword, double Sigma, RandGen &Rand)
+   { Manchester(Codeword, Sigma, Rand);
+     int Len   = 8+Rand.Word()%17;
+     int Start = Rand.Word()%(208-Len);                         // in the on-air order: MSB of every byte first
+     for(int Air=Start; Air<Start+Len; Air++)
+     { int Bit = Air^7;
+       uint8_t Mask = 1<<(Bit&7);
+       bool Chip0 = Rand.Word()&1;
+       bool Chip1 = Rand.Word()&1;
+       Data[Bit>>3] &= ~Mask; Err[Bit>>3] &= ~Mask;
+       float Value = 0;
+       if(Chip0!=Chip1) Value = Chip0 ? +1.0:-1.0;
+                   else Err[Bit>>3] |= Mask;
+       if(Chip0) Data[Bit>>3] |= Mask;
+       Soft[Bit^7] = Value; }
+   }
+} ;
+
+static int BitErrors(const uint32_t *Codeword, const uint32_t *Decoded) // in the 160 user bits
+{ int Count=0;
+  for(int Idx=0; Idx<5; Idx++)
+    Count+=Count1s(Codeword[Idx]^Decoded[Idx]);
+  return Count; }
+
+// decoder adapters: Decode() returns the number of failed checks, Iter is the number of iterations it took
+
+class FloodDecoder
+{ public:
+   static const char *Name(void) { return "Flood"; }
+   LDPC_Decoder Dec;
+   int Decode(const Channel &Rx, bool Soft, uint32_t *Out, int MaxIter, int &Iter)
+   { if(Soft) Dec.Input(Rx.Soft); else Dec.Input(Rx.Data, Rx.Err);
+     int Check=0;
+     for(Iter=0; Iter<MaxIter; Iter++)
+     { Check=Dec.ProcessChecks(); if(Check==0) break; }
+     Dec.Output(Out); return Check; }
+} ;
+
+class FloatDecoder
+{ public:
+   static const char *Name(void) { return "Float"; }
+   LDPC_FloatDecoder<float> Dec;
+   FloatDecoder() { Dec.Configure(208, 48, (const uint32_t *)LDPC_ParityCheck_n208k160); }
+   int Decode(const Channel &Rx, bool Soft, uint32_t *Out, int MaxIter, int &Iter)
+   { if(Soft)
+     { Dec.Clear();
+       for(int Bit=0; Bit<208; Bit++)
+         Dec.addInput(Bit, Rx.Soft[Bit^7]); }
+     else Dec.Input(Rx.Data, Rx.Err);
+     int Check=0;
+     for(Iter=0; Iter<MaxIter; Iter++)
+     { Check=Dec.ProcessChecks(); if(Check==0) break; }
+     Dec.Output(Out); return Check; }
+} ;
+
+template <class LLR>
+ class LayerDecoder
+{ public:
+   static const char *Name(void) { return sizeof(LLR)>1 ? "Layer16":"Layer8"; }
+   LDPC_LayeredDecoder<LLR> Dec;
+   int Decode(const Channel &Rx, bool Soft, uint32_t *Out, int MaxIter, int &Iter)
+   { if(Soft) Dec.Input(Rx.Soft); else Dec.Input(Rx.Data, Rx.Err);
+     int Check=0;
+     for(Iter=0; Iter<MaxIter; Iter++)
+     { Check=Dec.ProcessChecks(); if(Check==0) break; }
+     Dec.Output(Out); return Check; }
+} ;
+
+template <bool EarlyStop, bool Weighted=0>
+ class FlipLayerDecoder                                         // what the tracker does: bit-flipping first, then the 8-bit layered decoder
+{ public:
+   static const char *Name(void) { return Weighted ? "Flip+L8/W" : EarlyStop ? "Flip+L8/ES":"Flip+L8"; }
+   LDPC_LayeredDecoder<int8_t> Dec;
+   LDPC_EarlyStop Stop;
+   uint8_t NearWeight;                                          // [1/16] for the bits next to Manchester errors
+   FlipLayerDecoder() { NearWeight=16; }
+   int Decode(const Channel &Rx, bool Soft, uint32_t *Out, int MaxIter, int &Iter)
+   { uint32_t Erased[7];
+     Out[6]=0; Erased[6]=0;
+     memcpy(Out, Rx.Data, 26); memcpy(Erased, Rx.Err, 26);
+     Iter=0;
+     if(LDPC_FlipBits(Out, Erased)==0) return 0;
+     if(Soft) Dec.Input(Rx.Soft);
+     else if(Weighted) Dec.Input(Rx.Data, Rx.Err, 16, NearWeight);
+     else Dec.Input(Rx.Data, Rx.Err);
+     int Check=0; Stop.Start();
+     for(Iter=0; Iter<MaxIter; )
+     { Check=Dec.ProcessChecks(); if(Check==0) break;
+       Iter++;
+       if(EarlyStop && Stop.Stop(Check, Dec)) break; }
+     Dec.Output(Out); return Check; }
+} ;
+
+class Stat                                                      // statistics for one decoder at one Eb/N0
+{ public:
+   uint64_t Frames, FrameErr, BitErr, Undetected, Iter;
+
+  public:
+   Stat() { Clear(); }
+   void Clear(void) { Frames=0; FrameErr=0; BitErr=0; Undetected=0; Iter=0; }
+   void Add(const Stat &Other)
+   { Frames+=Other.Frames; FrameErr+=Other.FrameErr; BitErr+=Other.BitErr; Undetected+=Other.Undetected; Iter+=Other.Iter; }
+
+   void Process(const uint32_t *Codeword, const uint32_t *Decoded, int Check, int Iterations)
+   { Frames++; Iter+=Iterations;
+     int Errors=BitErrors(Codeword, Decoded);
+     if(Errors) { FrameErr++; BitErr+=Errors; if(Check==0) Undetected++; }
+   }
+
+   void Print(void) const
+   { printf(" %8.6f %9.3e %5.2f", (double)FrameErr/Frames, (double)BitErr/(160.0*Frames), (double)Iter/Frames);
+     if(Undetected) printf("!%-3d", (int)Undetected); else printf("    "); }
+} ;
+
+const int Decoders = 7;
+
+class Worker                                                    // one thread: the decoders and their statistics
+{ public:
+   FloodDecoder             Flood;
+   FloatDecoder             Float;
+   LayerDecoder<int16_t>    Layer16;
+   LayerDecoder<int8_t>     Layer8;
+   FlipLayerDecoder<0>      FlipLayer;
+   FlipLayerDecoder<1>      FlipLayerES;
+   FlipLayerDecoder<1, 1>   FlipLayerW;
+   Stat Result[Decoders];
+
+  public:
+   void Run(uint64_t Seed, uint64_t Block, int Packets, double Sigma, int Chan, int MaxIter)
+   { RandGen Rand(Seed ^ (Block*0xD1B54A32D192ED03ULL));
+     uint32_t Codeword[7], Decoded[7];
+     Channel Rx;
+     for(int Pkt=0; Pkt<Packets; Pkt++)
+     { RandomPacket(Codeword, Rand);
+       if(Chan==1) Rx.Manchester(Codeword, Sigma, Rand);
+       else if(Chan==2) Rx.Noise(Rand);
+       else if(Chan==3) Rx.Burst(Codeword, Sigma, Rand);
+       else Rx.AWGN(Codeword, Sigma, Rand);
+       bool Soft=Chan==0; int Iter, Check;
+       Check=Flood.Decode    (Rx, Soft, Decoded, MaxIter, Iter); Result[0].Process(Codeword, Decoded, Check, Iter);
+       Check=Float.Decode    (Rx, Soft, Decoded, MaxIter, Iter); Result[1].Process(Codeword, Decoded, Check, Iter);
+       Check=Layer16.Decode  (Rx, Soft, Decoded, MaxIter, Iter); Result[2].Process(Codeword, Decoded, Check, Iter);
+       Check=Layer8.Decode   (Rx, Soft, Decoded, MaxIter, Iter); Result[3].Process(Codeword, Decoded, Check, Iter);
+       Check=FlipLayer.Decode(Rx, Soft, Decoded, MaxIter, Iter); Result[4].Process(Codeword, Decoded, Check, Iter);
+       Check=FlipLayerES.Decode(Rx, Soft, Decoded, MaxIter, Iter); Result[5].Process(Codeword, Decoded, Check, Iter);
+       Check=FlipLayerW.Decode(Rx, Soft, Decoded, MaxIter, Iter); Result[6].Process(Codeword, Decoded, Check, Iter); }
+   }
+} ;
+
+int main(int argc, char *argv[])
+{ int Packets = 100000;                                         // per Eb/N0 point
+  int Threads = std::thread::hardware_concurrency(); if(Threads<1) Threads=1;
+  uint64_t Seed = 12345;
+  int MaxIter = 32;
+  double EbN0_From=2.0, EbN0_To=7.0, EbN0_Step=0.5;
+  int Chan=0;                                                   // 0=awgn, 1=manch, 2=noise, 3=burst
+  LDPC_EarlyStop Stop;
+  int NearWeight=16;                                            // as RFM_RxPktData::NearErrWeight in rfm.h
+
+  int Opt;
+  while((Opt=getopt(argc, argv, "c:n:t:s:i:f:e:d:x:w:"))!=(-1))
+  { switch(Opt)
+    { case 'c': Chan = strcmp(optarg, "manch")==0 ? 1 : strcmp(optarg, "noise")==0 ? 2 : strcmp(optarg, "burst")==0 ? 3:0; break;
+      case 'n': Packets = atoi(optarg); break;
+      case 't': Threads = atoi(optarg); break;
+      case 's': Seed = strtoull(optarg, 0, 0); break;
+      case 'i': MaxIter = atoi(optarg); break;
+      case 'f': EbN0_From = atof(optarg); break;
+      case 'e': EbN0_To = atof(optarg); break;
+      case 'd': EbN0_Step = atof(optarg); break;
+      case 'x': { int MinIter=Stop.MinIter, MaxRepeat=Stop.MaxRepeat, MaxFailed=Stop.MaxFailed;
+                  sscanf(optarg, "%d,%d,%d", &MinIter, &MaxRepeat, &MaxFailed);
+                  Stop.MinIter=MinIter; Stop.MaxRepeat=MaxRepeat; Stop.MaxFailed=MaxFailed; break; }
+      case 'w': NearWeight = atoi(optarg); break;
+      default:
+        printf("usage: %s [-c awgn|manch|noise|burst] [-n packets] [-t threads] [-s seed] [-i iterations] [-f from_dB] [-e to_dB] [-d step_dB]\n"
+               "          [-x MinIter,MaxRepeat,MaxFailed] [-w NearWeight]\n", argv[0]);
+        return 1; }
+  }
+  if(Threads<1) Threads=1;
+
+  const int BlockSize = 1000;                                   // packets per block: each block has its own seed
+  const double Rate = 160.0/208;
+  std::vector<Worker *> Work(Threads);
+  for(int Thr=0; Thr<Threads; Thr++)
+  { Work[Thr] = new Worker;
+    LDPC_EarlyStop &ThrStop = Work[Thr]->FlipLayerES.Stop;
+    ThrStop.MinIter=Stop.MinIter; ThrStop.MaxRepeat=Stop.MaxRepeat; ThrStop.MaxFailed=Stop.MaxFailed;
+    Work[Thr]->FlipLayerW.Stop=ThrStop;
+    Work[Thr]->FlipLayerW.NearWeight=NearWeight; }
+
+  const char *ChanName[4] = { "AWGN", "Manchester", "Noise", "Burst" };
+  printf("# %s channel, %d packets per point, %d iterations max., %d threads, seed %llu\n",
+         ChanName[Chan], Packets, MaxIter, Threads, (unsigned long long)Seed);
+  printf("# early stop: MinIter=%d, MaxRepeat=%d, MaxFailed=%d, near-error weight %d/16\n",
+         Stop.MinIter, Stop.MaxRepeat, Stop.MaxFailed, NearWeight);
+  printf("# Eb/N0");
+  printf(" %-29s", FloodDecoder::Name()); printf(" %-29s", FloatDecoder::Name());
+  printf(" %-29s", LayerDecoder<int16_t>::Name()); printf(" %-29s", LayerDecoder<int8_t>::Name());
+  printf(" %-29s", FlipLayerDecoder<0>::Name()); printf(" %-29s", FlipLayerDecoder<1>::Name());
+  printf(" %-29s\n", FlipLayerDecoder<1, 1>::Name());
+  printf("# [dB]"); for(int Dec=0; Dec<Decoders; Dec++) printf("  FER      BER       Iter     "); printf("\n");
+
+  for(double EbN0=EbN0_From; EbN0<=EbN0_To+0.001; EbN0+=EbN0_Step)
+  { double Sigma = sqrt(1.0/(2*Rate*pow(10.0, 0.1*EbN0)));
+    if( (Chan==1) || (Chan==3) ) Sigma*=sqrt(2.0);                                 // the bit energy is split between two chips
+    int Blocks = (Packets+BlockSize-1)/BlockSize;
+    std::atomic<int> NextBlock(0);
+    std::vector<std::thread> Pool;
+    for(int Thr=0; Thr<Threads; Thr++)
+    { Worker *Wrk = Work[Thr];
+      for(int Dec=0; Dec<Decoders; Dec++) Wrk->Result[Dec].Clear();
+      Pool.push_back(std::thread([&, Wrk]()
+      { for( ; ; )
+        { int Block = NextBlock++;
+          if(Block>=Blocks) break;
+          int Count = Packets-Block*BlockSize; if(Count>BlockSize) Count=BlockSize;
+          Wrk->Run(Seed, Block, Count, Sigma, Chan, MaxIter); }
+      } ));
+    }
+    for(int Thr=0; Thr<Threads; Thr++) Pool[Thr].join();
+    printf("%5.2f ", EbN0);
+    for(int Dec=0; Dec<Decoders; Dec++)
+    { Stat Sum;
+      for(int Thr=0; Thr<Threads; Thr++) Sum.Add(Work[Thr]->Result[Dec]);
+      Sum.Print(); }
+    printf("\n"); fflush(stdout); }
+
+  for(int Thr=0; Thr<Threads; Thr++) delete Work[Thr];
+  return 0; }
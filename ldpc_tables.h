@@ -0,0 +1,90 @@
+#ifndef __LDPC_TABLES_H__
+#define __LDPC_TABLES_H__
+
+// Decoder tables derived at compile time from a parity-check matrix (needs C++14 constexpr: -std=gnu++14 or newer).
+// The matrix is given as rows of 32-bit words, bit b of a row is word b>>5, bit b&31, like LDPC_ParityCheck_n208k160.
+// The results are constants thus they go to flash, same as the hand-written tables did.
+
+#include <stdint.h>
+
+template <int Rows, int MaxWeight, class Idx=uint8_t>
+ struct LDPC_IndexTable                                  // [Row][0] = row weight, followed by the indicies of the bits in that check
+{ Idx Index[Rows][MaxWeight]; } ;
+
+template <int Bits>
+ struct LDPC_WeightTable                                 // column weight: in how many checks is every bit
+{ uint8_t Weight[Bits]; } ;
+
+template <int Groups, int Words>
+ struct LDPC_MaskTable                                   // bit masks: which bits have given column weight
+{ uint32_t Mask[Groups][Words]; } ;
+
+template <int Cols, int Words>
+ struct LDPC_ColumnTable                                 // columns of a generator matrix: parity bits flipped by every data bit
+{ uint32_t Column[Cols][Words]; } ;
+
+template <int Pieces, int Values>
+ struct LDPC_PieceTable                                  // parity of every value of every data piece: bits 0..31 and 32..47
+{ uint32_t Low [Pieces][Values];
+  uint16_t High[Pieces][Values]; } ;
+
+template <int Words>
+ constexpr bool LDPC_MatrixBit(const uint32_t (&Row)[Words], int Bit)
+{ return (Row[Bit>>5]>>(Bit&31))&1; }
+
+// check index: a row heavier than MaxWeight-1 writes outside the table which stops the compilation
+template <int MaxWeight, class Idx=uint8_t, int Rows, int Words>
+ constexpr LDPC_IndexTable<Rows, MaxWeight, Idx> LDPC_CheckIndex(const uint32_t (&Check)[Rows][Words], int Bits=Words*32)
+{ LDPC_IndexTable<Rows, MaxWeight, Idx> Table { };
+  for(int Row=0; Row<Rows; Row++)
+  { int Weight=0;
+    for(int Bit=0; Bit<Bits; Bit++)
+      if(LDPC_MatrixBit(Check[Row], Bit)) Table.Index[Row][1+Weight++]=Bit;
+    Table.Index[Row][0]=Weight; }
+  return Table; }
+
+template <int Bits, int Rows, int Words>
+ constexpr LDPC_WeightTable<Bits> LDPC_BitWeight(const uint32_t (&Check)[Rows][Words])
+{ LDPC_WeightTable<Bits> Table { };
+  for(int Row=0; Row<Rows; Row++)
+    for(int Bit=0; Bit<Bits; Bit++)
+      if(LDPC_MatrixBit(Check[Row], Bit)) Table.Weight[Bit]++;
+  return Table; }
+
+// masks of bits with weight MinWeight, MinWeight+1, ... MinWeight+Groups-1
+template <int Bits, int MinWeight, int Groups, int Rows, int Words>
+ constexpr LDPC_MaskTable<Groups, Words> LDPC_BitWeightMask(const uint32_t (&Check)[Rows][Words])
+{ LDPC_MaskTable<Groups, Words> Table { };
+  LDPC_WeightTable<Bits> BitWeight = LDPC_BitWeight<Bits>(Check);
+  for(int Bit=0; Bit<Bits; Bit++)
+  { int Group = BitWeight.Weight[Bit]-MinWeight;
+    if( (Group>=0) && (Group<Groups) ) Table.Mask[Group][Bit>>5] |= (uint32_t)1<<(Bit&31); }
+  return Table; }
+
+// parity contribution of the data bits FirstBit .. FirstBit+Cols-1: as the code is linear, flipping a data bit
+// flips the parity bits given by its column of the generator matrix, thus a change in few data bits can be patched into the parity
+template <int Cols, int Rows, int DataWords>
+ constexpr LDPC_ColumnTable<Cols, (Rows+31)/32> LDPC_ParityColumns(const uint32_t (&Gen)[Rows][DataWords], int FirstBit=0)
+{ LDPC_ColumnTable<Cols, (Rows+31)/32> Table { };
+  for(int Col=0; Col<Cols; Col++)
+    for(int Row=0; Row<Rows; Row++)
+      if(LDPC_MatrixBit(Gen[Row], FirstBit+Col)) Table.Column[Col][Row>>5] |= (uint32_t)1<<(Row&31);
+  return Table; }
+
+// parity of every value of every PieceBits-wide piece of the data: the XOR of the columns of the bits set in the value,
+// thus a table-driven encoder needs one lookup per piece. Made for up to 48 parity bits.
+template <int PieceBits, int Rows, int DataWords>
+ constexpr LDPC_PieceTable<DataWords*32/PieceBits, 1<<PieceBits> LDPC_PieceParity(const uint32_t (&Gen)[Rows][DataWords])
+{ static_assert(Rows<=48, "LDPC_PieceParity: up to 48 parity bits");
+  LDPC_PieceTable<DataWords*32/PieceBits, 1<<PieceBits> Table { };
+  LDPC_ColumnTable<DataWords*32, 2> Column = LDPC_ParityColumns<DataWords*32>(Gen);
+  for(int Piece=0; Piece<DataWords*32/PieceBits; Piece++)
+    for(int Val=1; Val<(1<<PieceBits); Val++)
+    { int Bit=0; while(((Val>>Bit)&1)==0) Bit++;         // the lowest bit set in the value
+      int Prev=Val&(Val-1);                               // the value without that bit: already done
+      const uint32_t *Col = Column.Column[Piece*PieceBits+Bit];
+      Table.Low [Piece][Val] = Table.Low [Piece][Prev] ^ Col[0];
+      Table.High[Piece][Val] = Table.High[Piece][Prev] ^ (uint16_t)Col[1]; }
+  return Table; }
+
+#endif // __LDPC_TABLES_H__
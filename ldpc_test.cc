@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ldpc.h"
+#include "hosttest.h"
+
+// compare the flooding (LDPC_Decoder) against the layered (LDPC_LayeredDecoder) schedule
+// on random codewords sent through an AWGN channel with BPSK-like soft decisions
+// and the hard-decision bit-flipping (LDPC_FlipBits) as the first stage before the soft decoder
+// and check that the 8-bit layered decoder gives the same output as the 16-bit one on hard bits + erasures
+
+static void RandomCodeword(uint32_t *Codeword)                  // random user data + the parity bits
+{ for(int Idx=0; Idx<5; Idx++)
+    Codeword[Idx] = ((uint32_t)random()<<16) ^ random();
+  LDPC_Encode(Codeword); }
+
+static void Transmit(float *Soft, const uint32_t *Codeword, double Sigma) // soft decisions in the on-air (MSB first) bit order
+{ for(int Bit=0; Bit<208; Bit++)
+  { double Ampl = ((Codeword[Bit>>5]>>(Bit&31))&1) ? +1.0:-1.0;
+    Soft[Bit^7] = Ampl + Sigma*GaussNoise(); }
+}
+
+static int BitErrors(const uint32_t *Codeword, const uint32_t *Decoded)
+{ int Count=0;
+  for(int Idx=0; Idx<7; Idx++)
+  { uint32_t Diff = Codeword[Idx]^Decoded[Idx];
+    if(Idx==6) Diff&=0xFFFF;
+    Count+=Count1s(Diff); }
+  return Count; }
+
+static void HardDecision(uint32_t *Data, uint32_t *Erased, const float *Soft, float Thres) // hard bits + erasures like from the Manchester decoder
+{ for(int Idx=0; Idx<7; Idx++) { Data[Idx]=0; Erased[Idx]=0; }
+  for(int Bit=0; Bit<208; Bit++)
+  { float Ampl = Soft[Bit^7];
+    uint32_t Mask = (uint32_t)1<<(Bit&31);
+    if(Ampl>0) Data[Bit>>5]|=Mask;
+    if(fabs(Ampl)<Thres) Erased[Bit>>5]|=Mask; }
+}
+
+class HardStat                                                  // hard bits + erasures (like from the RF chip) into the layered decoder
+{ public:                                                       // optionally with the bit-flipping first
+   LDPC_LayeredDecoder<> Dec;
+   int MaxIter;
+   bool WithFlip;
+   int Packets, Errors, Flipped, FlipErrors;
+   double CPU;
+
+  public:
+   HardStat(int Iter=16, bool Flip=1) { MaxIter=Iter; WithFlip=Flip; Clear(); }
+   void Clear(void) { Packets=0; Errors=0; Flipped=0; FlipErrors=0; CPU=0; }
+
+   void Process(const float *Soft, const uint32_t *Codeword, int Count)
+   { uint32_t *Data   = new uint32_t[Count*7];
+     uint32_t *Erased = new uint32_t[Count*7];
+     for(int Pkt=0; Pkt<Count; Pkt++)                           // the RF chip delivers hard bits: not included in the timing
+       HardDecision(Data+Pkt*7, Erased+Pkt*7, Soft+Pkt*208, 0.25);
+     clock_t Start=clock();
+     for(int Pkt=0; Pkt<Count; Pkt++, Codeword+=7)
+     { uint32_t *Decoded = Data+Pkt*7;
+       Packets++;
+       if(WithFlip)
+       { uint32_t Flip[7];
+         for(int Idx=0; Idx<7; Idx++) Flip[Idx]=Decoded[Idx];
+         if(LDPC_FlipBits(Flip, Erased+Pkt*7)==0)
+         { Flipped++;
+           if(BitErrors(Codeword, Flip)) { Errors++; FlipErrors++; }
+           continue; }
+       }
+       Dec.Input((const uint8_t *)Decoded, (const uint8_t *)(Erased+Pkt*7));
+       for(int Iter=0; Iter<MaxIter; Iter++)
+       { if(Dec.ProcessChecks()==0) break; }
+       Dec.Output(Decoded);
+       if(BitErrors(Codeword, Decoded)) Errors++; }
+     CPU += (double)(clock()-Start)/CLOCKS_PER_SEC;
+     delete [] Data; delete [] Erased; }
+
+   void Print(const char *Name) const
+   { printf(" %s: FER=%7.5f Flip=%5.3f (false %d) %5.2fus/pkt", Name, (double)Errors/Packets, (double)Flipped/Packets, FlipErrors, 1e6*CPU/Packets); }
+
+} ;
+
+static int CompareCompact(const float *Soft, int Count, int MaxIter=16) // count packets decoded differently by the 16-bit and 8-bit decoders
+{ static LDPC_LayeredDecoder<int16_t> Dec16;
+  static LDPC_LayeredDecoder<int8_t>  Dec8;
+  int Diff=0;
+  for(int Pkt=0; Pkt<Count; Pkt++, Soft+=208)
+  { uint32_t Data[7], Erased[7];
+    HardDecision(Data, Erased, Soft, 0.25);
+    Dec16.Input((const uint8_t *)Data, (const uint8_t *)Erased);
+    Dec8.Input((const uint8_t *)Data, (const uint8_t *)Erased);
+    int Check16=0, Check8=0;
+    for(int Iter=0; Iter<MaxIter; Iter++) { Check16=Dec16.ProcessChecks(); if(Check16==0) break; }
+    for(int Iter=0; Iter<MaxIter; Iter++) { Check8 =Dec8.ProcessChecks();  if(Check8 ==0) break; }
+    uint32_t Out16[7], Out8[7];
+    Dec16.Output(Out16); Dec8.Output(Out8);
+    if( (Check16==0) != (Check8==0) ) { Diff++; continue; }        // one decoder succeeds, the other fails
+    if( (Check16==0) && BitErrors(Out16, Out8) ) Diff++; }          // both succeed but with a different codeword
+  return Diff; }
+
+template <class Decoder>
+ class DecoderStat
+{ public:
+   Decoder Dec;
+   int MaxIter;
+   int Packets, Errors, Iterations;
+   double CPU;
+
+  public:
+   DecoderStat(int Iter=32) { MaxIter=Iter; Clear(); }
+   void Clear(void) { Packets=0; Errors=0; Iterations=0; CPU=0; }
+
+   void Process(const float *Soft, const uint32_t *Codeword, int Count)   // decode a batch of packets
+   { clock_t Start=clock();
+     for(int Pkt=0; Pkt<Count; Pkt++, Soft+=208, Codeword+=7)
+     { uint32_t Decoded[7];
+       Dec.Input(Soft);
+       int Iter;
+       for(Iter=0; Iter<MaxIter; Iter++)
+       { if(Dec.ProcessChecks()==0) break; }
+       Dec.Output(Decoded);
+       Packets++; Iterations+=Iter;
+       if(BitErrors(Codeword, Decoded)) Errors++; }
+     CPU += (double)(clock()-Start)/CLOCKS_PER_SEC; }
+
+   void Print(const char *Name) const
+   { printf(" %s: FER=%7.5f Iter=%5.2f %5.2fus/pkt", Name, (double)Errors/Packets, (double)Iterations/Packets, 1e6*CPU/Packets); }
+
+} ;
+
+int main(int argc, char *argv[])
+{ int Packets = 10000;
+  if(argc>1) Packets=atoi(argv[1]);
+
+  const double Rate = 160.0/208;
+  uint32_t *Codeword = new uint32_t[Packets*7];
+  float    *Soft     = new float[Packets*208];
+
+  DecoderStat<LDPC_Decoder>        Flood(32);
+  DecoderStat<LDPC_LayeredDecoder<> > Layer(32);
+  DecoderStat<LDPC_LayeredDecoder<> > Layer16(16);
+  HardStat                         Hard16(16, 0);
+  HardStat                         Flip16(16, 1);
+
+  for(double EbN0=2.0; EbN0<=6.01; EbN0+=0.5)                  // [dB]
+  { double Sigma = sqrt(1.0/(2*Rate*pow(10.0, 0.1*EbN0)));
+    srandom(12345);
+    for(int Pkt=0; Pkt<Packets; Pkt++)
+    { RandomCodeword(Codeword+Pkt*7);
+      Transmit(Soft+Pkt*208, Codeword+Pkt*7, Sigma); }
+    Flood.Clear(); Layer.Clear(); Layer16.Clear(); Hard16.Clear(); Flip16.Clear();
+    Flood.Process(Soft, Codeword, Packets);
+    Layer.Process(Soft, Codeword, Packets);
+    Layer16.Process(Soft, Codeword, Packets);
+    Hard16.Process(Soft, Codeword, Packets);
+    Flip16.Process(Soft, Codeword, Packets);
+    printf("Eb/N0=%3.1fdB:", EbN0);
+    Flood.Print("Flood/32"); Layer.Print("Layer/32"); Layer16.Print("Layer/16");
+    printf("\n            "); printf(" 8-bit vs 16-bit: %d/%d packets differ\n            ", CompareCompact(Soft, Packets), Packets);
+    Hard16.Print("Hard/16"); Flip16.Print("Flip+Hard/16");
+    printf("\n"); }
+
+  delete [] Codeword; delete [] Soft;
+  return 0; }
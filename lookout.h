@@ -0,0 +1,151 @@
+#ifndef __LOOKOUT_H__
+#define __LOOKOUT_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "intmath.h"
+#include "ogn.h"
+
+// Collision prediction: own aircraft and every target are projected along circular paths (constant speed, climb and turn rate)
+// in one second steps up to Steps seconds ahead. For every step the closest approach of the relative (linear within the step)
+// motion is found: when the horizontal and the vertical miss distance are both inside the protected zone
+// (which grows with the prediction time) the time to that conflict sets the FLARM alarm level.
+// The work per target is bounded: a target which can not reach the protected zone in the remaining time is given up early.
+
+class LookOut_Motion                              // position and velocity of an aircraft, advanced in one second steps
+{ public:
+   int32_t N, E, U;                              // [1/16 m] position: north, east, up
+   int32_t VN, VE, VU;                           // [1/16 m/sec] velocity
+   int16_t Cos, Sin;                             // [2^-12] rotation of the velocity vector in one second
+   bool    Turn;                                 // the path is a circle, not a line
+
+   static const int16_t MaxAccel  = 100;         // [0.1m/s^2] turn rates which would need more centripetal acceleration are not trusted
+   static const int16_t MaxRadius = 4000;        // [m] larger turns are taken as straight flight
+
+  public:
+   void Set(int32_t North, int32_t East, int32_t Up,                      // [m]
+            int16_t Speed, int16_t Heading, int16_t Climb, int16_t TurnRate) // [0.1m/s], [0.1deg], [0.1m/s], [0.1deg/s]
+   { N=North<<4; E=East<<4; U=Up<<4;
+     int16_t Dir = ((int32_t)Heading*37283+0x400)>>11;                    // [0.1deg] => [2^-16 full angle]
+     int32_t V   = ((int32_t)Speed*8+2)/5;                                // [0.1m/s] => [1/16 m/sec]
+     VN = (V*Icos(Dir)+0x800)>>12;                                        // Isin()/Icos() give 12-bit fractions
+     VE = (V*Isin(Dir)+0x800)>>12;
+     VU = ((int32_t)Climb*8+2)/5;
+     int16_t Accel = OGN_Packet::calcCPaccel(Speed, TurnRate);            // [0.1m/s^2]
+     if(abs(Accel)>MaxAccel) TurnRate = ((int32_t)TurnRate*MaxAccel)/abs(Accel); // limit the turn to what the aircraft can do
+     Turn = OGN_Packet::calcTurnRadius(Speed, TurnRate, MaxRadius)!=0;    // zero when not turning or a very wide turn
+     if(!Turn) { Cos=0x1000; Sin=0; return; }
+     int16_t Rot = ((int32_t)TurnRate*37283+0x400)>>11;                   // [0.1deg/s] => [2^-16 full angle per second]
+     Cos=Icos(Rot); Sin=Isin(Rot); }
+
+   void Step(void)                                                        // advance by one second
+   { if(Turn)                                                             // rotate the velocity by the turn of half a step before and after the move
+     { int32_t NewVN = (VN*Cos-VE*Sin+0x800)>>12;                        // which puts the chord close to the circle
+       int32_t NewVE = (VE*Cos+VN*Sin+0x800)>>12;
+       N+=(VN+NewVN)>>1; E+=(VE+NewVE)>>1; VN=NewVN; VE=NewVE; }
+     else { N+=VN; E+=VE; }
+     U+=VU; }
+
+   int32_t Reach(void) const { return abs(VN)+abs(VE); }                  // [1/16 m/sec] upper limit of the horizontal speed
+
+} ;
+
+class LookOut_Alarm                               // the prediction for one target
+{ public:
+   uint8_t  Level;                               // 0 = no alarm, 1 = 13-18 sec, 2 = 9-12 sec, 3 = 0-8 sec to the conflict
+   uint8_t  Time;                                // [sec] to the conflict or to the closest approach
+   uint16_t MissDist;                            // [m] horizontal distance at that time
+    int16_t MissAlt;                             // [m] relative altitude at that time
+    int16_t Bearing;                             // [deg] of the target now, relative to own track, -180..+180
+   uint16_t Dist;                                // [m] horizontal distance now
+    int16_t RelAlt;                              // [m] relative altitude now
+
+  public:
+   void Clear(void) { Level=0; Time=0; MissDist=0xFFFF; MissAlt=0; Bearing=0; Dist=0; RelAlt=0; }
+
+} ;
+
+class LookOut
+{ public:
+   static const uint8_t Steps   = 20;            // [sec] how far ahead to predict
+   static const uint8_t MaxAge  =  8;            // [sec] older positions are not predicted
+   static const int32_t MaxDist = 10000;         // [m] further targets are ignored
+   static const uint16_t ZoneDist = 80;          // [m] protected zone: horizontal
+   static const uint16_t ZoneDistRate = 4;       // [m/sec] growth with the prediction time (uncertainty of the prediction)
+   static const uint16_t ZoneAlt  = 40;          // [m] vertical
+   static const uint16_t ZoneAltRate  = 2;       // [m/sec]
+
+   int32_t  Latitude, Longitude, Altitude;       // [0.0001/60deg], [0.0001/60deg], [m] own position
+   uint16_t LatCos;                              // [2^-12]
+   int16_t  Speed, Heading, Climb, TurnRate;     // [0.1m/s], [0.1deg], [0.1m/s], [0.1deg/s] own motion
+   uint8_t  Sec;                                 // [sec] own position time
+   bool     Valid;                               // own position is known
+
+   uint16_t StepCount;                           // steps made since clearStat(): the cost of the predictions
+
+  public:
+   LookOut() { Valid=0; StepCount=0; }
+
+   void setOwn(const GPS_Position &Position)
+   { setOwn(Position.Latitude, Position.Longitude, (Position.Altitude+5)/10, Position.LatitudeCosine,
+            Position.Speed, Position.Heading, Position.ClimbRate, Position.TurnRate, Position.Sec); }
+
+   void setOwn(int32_t Lat, int32_t Lon, int32_t Alt, uint16_t Cos, int16_t OwnSpeed, int16_t OwnHeading, int16_t OwnClimb, int16_t OwnTurn, uint8_t OwnSec)
+   { Latitude=Lat; Longitude=Lon; Altitude=Alt; LatCos=Cos;
+     Speed=OwnSpeed; Heading=OwnHeading; Climb=OwnClimb; TurnRate=OwnTurn; Sec=OwnSec;
+     Valid=1; }
+
+   void clearStat(void) { StepCount=0; }
+
+   // predict the target given by its decoded position View taken at time Time [sec]: returns the alarm level
+   uint8_t Check(LookOut_Alarm &Alarm, const OGN_PacketView &View, uint8_t Time)
+   { Alarm.Clear();
+     if(!Valid) return 0;
+     uint8_t Age = (Sec+60-Time)%60;
+     if( (Time>=60) || (Age>MaxAge) ) return 0;
+     int32_t LatDist, LonDist;
+     if(OGN_PacketView::calcDistanceVector(LatDist, LonDist, View.Latitude, View.Longitude, Latitude, Longitude, LatCos, MaxDist)<0) return 0;
+     LookOut_Motion Own, Target;
+     Own.Set(0, 0, 0, Speed, Heading, Climb, TurnRate);
+     Target.Set(LatDist, LonDist, View.Altitude-Altitude, View.Speed, View.Heading, View.ClimbRate, View.TurnRate);
+     for( ; Age; Age--) { Target.Step(); StepCount++; }                    // bring the target to the own position time
+     int32_t RelN = Target.N-Own.N, RelE = Target.E-Own.E, RelU = Target.U-Own.U;
+     Alarm.Dist   = IntDistance(RelN>>4, RelE>>4);
+     Alarm.RelAlt = RelU>>4;
+     int16_t Dir  = IntAtan2(Limit(RelE>>4), Limit(RelN>>4))-(int16_t)(((int32_t)Heading*37283+0x400)>>11);
+     Alarm.Bearing = ((int32_t)Dir*360+0x8000)>>16;
+     int32_t Reach = Own.Reach()+Target.Reach();                           // [1/16 m/sec] how fast the distance can decrease
+     for(uint8_t Step=0; Step<Steps; Step++)
+     { int32_t Zone = (ZoneDist+ZoneDistRate*(Step+1))<<4;               // [1/16 m] horizontal zone at the end of this step
+       int32_t Far  = abs(RelN)>abs(RelE) ? abs(RelN):abs(RelE);
+       if(Far > Reach*(Steps-Step)+Zone) break;                           // can not get into the zone before the end of the prediction
+       Own.Step(); Target.Step(); StepCount++;
+       int32_t NextN = Target.N-Own.N, NextE = Target.E-Own.E, NextU = Target.U-Own.U;
+       int32_t DN = NextN-RelN, DE = NextE-RelE;                          // relative motion within this step
+       bool Near = Far <= Zone+abs(DN)+abs(DE);                           // the zone can be reached within this step
+       int32_t Frac = 0;                                                  // [1/256] time of the closest approach within the step
+       if(Near && (DN|DE))                                                // find the closest point: near thus the products do not overflow
+       { int32_t Dot = -(((RelN>>4)*DN+(RelE>>4)*DE)>>4);               // [m^2]
+         int32_t Len = ((DN>>4)*DN+(DE>>4)*DE)>>4;                        // [m^2]
+         if(Dot>0) Frac = Len>0 ? (Dot<Len ? (Dot<<8)/Len : 256) : 0; }
+       else if( (abs(NextN)+abs(NextE)) < (abs(RelN)+abs(RelE)) ) Frac=256;
+       int32_t MissN = RelN+((DN*Frac)>>8), MissE = RelE+((DE*Frac)>>8), MissU = RelU+(((NextU-RelU)*Frac)>>8);
+       uint16_t Miss;                                                     // [m] horizontal miss distance
+       if(Near) Miss = IntDistance((int16_t)(MissN>>4), (int16_t)(MissE>>4));
+           else { int32_t Max = abs(MissN)>abs(MissE) ? abs(MissN):abs(MissE); Max>>=4; Miss = Max<0xFFFF ? Max:0xFFFF; } // far: only an estimate
+       uint8_t  Time = Step+((Frac+128)>>8);
+       if(Miss<Alarm.MissDist) { Alarm.MissDist=Miss; Alarm.MissAlt=MissU>>4; Alarm.Time=Time; }
+       if( (Miss<=(Zone>>4)) && (abs(MissU>>4)<=(int32_t)(ZoneAlt+ZoneAltRate*(Step+1))) )
+       { Alarm.MissDist=Miss; Alarm.MissAlt=MissU>>4; Alarm.Time=Time;    // conflict: the earliest one counts
+         Alarm.Level = Time<=8 ? 3 : Time<=12 ? 2 : Time<=18 ? 1 : 0;
+         break; }
+       RelN=NextN; RelE=NextE; RelU=NextU; }
+     return Alarm.Level; }
+
+  private:
+   static int16_t Limit(int32_t X) { return X>0x7FFF ? 0x7FFF : X<(-0x7FFF) ? (-0x7FFF) : X; }
+
+} ;
+
+#endif // __LOOKOUT_H__
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "lookout.h"
+
+// collision prediction (lookout.h): alarm levels for a few known encounters
+// and the cost of one pass over 50 targets around a start/thermal, which must stay within the per-second budget of the MCU.
+// The budget is in STM32F103 (Cortex-M3, 72MHz) cycles: the steps counted by LookOut are multiplied by an estimate
+// of the cycles per step and per target, as the host time tells nothing about the MCU.
+// The tracker keeps only 16 targets (OGN_TrafficTable<16> in proc.cpp), 50 leaves the margin for a larger table.
+// compile: g++ -O2 -std=gnu++14 lookout_test.cc intmath.cpp format.cpp ldpc.cpp bitcount.cpp -o lookout_test
+
+static const int32_t RefLat = 46*600000;                           // [0.0001/60deg]
+static const int32_t RefLon =  7*600000;
+static const uint16_t RefCos = 2845;                                // [2^-12] cos(46deg)
+
+static const int      Targets      = 50;
+static const uint32_t CPU_Clock    = 72000000;                      // [Hz]
+static const uint32_t StepCycles   =  300;                          // [cycles] one step with the closest approach and IntDistance() (instruction count estimate)
+static const uint32_t TargetCycles = 1000;                          // [cycles] per target: distance vector, two LookOut_Motion::Set(), bearing
+static const uint32_t Budget       = CPU_Clock/200;                 // [cycles] per pass (per second): 5ms or 0.5% of the CPU
+static const uint32_t WorstCase    = Targets*((LookOut::Steps+LookOut::MaxAge)*StepCycles+TargetCycles); // without giving up on any target
+
+static void Place(OGN_PacketView &View, double North, double East, double Alt, double Speed, double Heading, double Climb, double Turn) // [m], [m/s], [deg], [deg/s]
+{ View.Latitude  = RefLat + (int32_t)floor(North*27/5+0.5);
+  View.Longitude = RefLon + (int32_t)floor((East*4096/RefCos)*27/5+0.5);
+  View.Altitude  = (int32_t)floor(Alt+0.5);
+  View.Speed     = (int16_t)floor(Speed*10+0.5);
+  View.Heading   = (int16_t)floor(fmod(Heading+360, 360)*10+0.5);
+  View.ClimbRate = (int16_t)floor(Climb*10+0.5);
+  View.TurnRate  = (int16_t)floor(Turn*10+0.5); }
+
+static int Expect(LookOut &Look, const char *Name, const OGN_PacketView &View, uint8_t MinLevel, uint8_t MaxLevel)
+{ LookOut_Alarm Alarm;
+  uint8_t Level=Look.Check(Alarm, View, Look.Sec);
+  printf("%-28s level %d (expect %d..%d) time %2ds miss %5dm/%+4dm bearing %+4ddeg dist %5dm\n",
+         Name, Level, MinLevel, MaxLevel, Alarm.Time, Alarm.MissDist, Alarm.MissAlt, Alarm.Bearing, Alarm.Dist);
+  return (Level<MinLevel) || (Level>MaxLevel); }
+
+int main(int argc, char *argv[])
+{ int Errors=0;
+  LookOut Look;
+  OGN_PacketView View;
+
+  Look.setOwn(RefLat, RefLon, 1000, RefCos, 300, 0, 0, 0, 30);    // own: 30m/s north, straight
+  Place(View, 600,    0, 1000, 30, 180, 0, 0); Errors+=Expect(Look, "head-on 600m",        View, 2, 3); // 10 sec to the collision
+  Place(View,1000,    0, 1000, 30, 180, 0, 0); Errors+=Expect(Look, "head-on 1000m",       View, 1, 1); // 17 sec
+  Place(View,3000,    0, 1000, 30, 180, 0, 0); Errors+=Expect(Look, "head-on 3000m",       View, 0, 0); // 50 sec
+  Place(View, 600,    0, 1300, 30, 180, 0, 0); Errors+=Expect(Look, "head-on 300m above",  View, 0, 0);
+  Place(View, 600,  500, 1000, 30, 180, 0, 0); Errors+=Expect(Look, "opposite, 500m aside",View, 0, 0);
+  Place(View,   0,  300, 1000, 30,   0, 0, 0); Errors+=Expect(Look, "parallel 300m",       View, 0, 0);
+  Place(View,-200,    0, 1000, 40,   0, 0, 0); Errors+=Expect(Look, "overtaking from behind",View,2, 3);
+  Place(View, 300, -300, 1000, 30,  90, 0, 0); Errors+=Expect(Look, "crossing from the left",View,2, 3); // 10 sec
+
+  Look.setOwn(RefLat, RefLon, 1000, RefCos, 250, 900, 20, 150, 30); // own: circling right in a thermal, 15deg/s
+  Place(View, -330,  0, 1000, 25, 270, 2, 15); Errors+=Expect(Look, "same thermal, opposite", View, 1, 3);
+  Place(View, -330,  0, 1150, 25, 270, 2, 15); Errors+=Expect(Look, "same thermal, 150m above", View, 0, 0);
+  Place(View, 2000,  0, 1000, 25,  90, 2, 15); Errors+=Expect(Look, "other thermal 2km",  View, 0, 0);
+
+  printf("budget %d cycles per pass, %d cycles when every target takes all steps\n", Budget, WorstCase);
+  if(WorstCase<=Budget) printf("(the budget does not test the early give-up)\n");
+  for(int Range=5000; Range>=500; Range/=10)                      // 50 gliders around a start: spread over 5km then packed within 500m
+  { OGN_PacketView Target[Targets];
+    srandom(1);
+    for(int Idx=0; Idx<Targets; Idx++)                              // some circling, positions up to 2 sec old
+    { double Dist = 100+random()%(Range-100), Dir = random()%360;
+      Place(Target[Idx], Dist*cos(Dir*M_PI/180), Dist*sin(Dir*M_PI/180), 800+random()%400,
+            20+random()%20, random()%360, (random()%50-25)*0.1, (Idx&1) ? (random()%40-20) : 0); }
+    Look.setOwn(RefLat, RefLon, 1000, RefCos, 300, 450, 0, 0, 30);
+    int Passes=20000; uint32_t MaxSteps=0; int Alarms=0;
+    clock_t Start=clock();
+    for(int Pass=0; Pass<Passes; Pass++)
+    { Look.clearStat(); Alarms=0;
+      for(int Idx=0; Idx<Targets; Idx++)
+      { LookOut_Alarm Alarm;
+        if(Look.Check(Alarm, Target[Idx], (30+60-(Idx%3))%60)) Alarms++; }
+      if(Look.StepCount>MaxSteps) MaxSteps=Look.StepCount; }
+    double Time = 1e6*(clock()-Start)/CLOCKS_PER_SEC/Passes;
+    uint32_t MCU_Cycles = MaxSteps*StepCycles+Targets*TargetCycles;
+    printf("%d targets within %4dm: %4d steps = %6d cycles per pass (%3d%% of the budget), %5.1f us per pass on this host, %2d alarms\n",
+           Targets, Range, MaxSteps, MCU_Cycles, 100*MCU_Cycles/Budget, Time, Alarms);
+    if(MCU_Cycles>Budget) Errors++; }
+
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
@@ -9,7 +9,8 @@
 
 #include "gps.h"                     // GPS task:  read the GPS receiver
 #include "rf.h"                      // RF task:   transmit/received packets on radio
-#include "proc.h"
+#include "proc.h"                    // PROC task: process received packets, prepare packets for transmission
+#include "fec.h"                     // FEC task:  correct received packets with errors
 #include "ctrl.h"                    // CTRL task: write log file to SD card
 #include "sens.h"                    // SENS task: read I2C sensors (baro for now)
 #include "knob.h"                    // KNOB task: read user knob
@@ -82,7 +83,8 @@ int main(void)
 #endif
   xTaskCreate(vTaskGPS,   "GPS",    100, 0, tskIDLE_PRIORITY+1, 0);  // GPS: GPS NMEA/PPS, packet encoding
   xTaskCreate(vTaskRF,    "RF",     120, 0, tskIDLE_PRIORITY+1, 0);  // RF: RF chip, time slots, frequency switching, packet reception and error correction
-  xTaskCreate(vTaskPROC,  "PROC",   160, 0, tskIDLE_PRIORITY  , 0);  // processing received packets and prepare packets for transmission
+  xTaskCreate(vTaskPROC,  "PROC",   160, 0, tskIDLE_PRIORITY+1, 0);  // processing received packets and prepare packets for transmission
+  xTaskCreate(vTaskFEC,   "FEC",    160, 0, tskIDLE_PRIORITY  , 0);  // FEC: correct received packets, below PROC so the time-slot work is not delayed; the stack PROC had for the decoder
   xTaskCreate(vTaskSENS,  "SENS",   128, 0, tskIDLE_PRIORITY+1, 0);  // SENS: BMP180 pressure, correlate with GPS
 
   vTaskStartScheduler();
@@ -99,7 +101,7 @@ int main(void)
 // + send received positions to console
 // + send received positions to console as $POGNT
 // + print number of detected transmission errors
-// . avoid printing same position twice (from both time slots)
+// + avoid printing same position twice (from both time slots)
 // + send Rx noise and packet stat. as $POGNR
 //
 // . optimize receiver sensitivity
@@ -110,7 +112,7 @@ int main(void)
 // + packet pools for queing
 // + separate task for FEC correction
 // + separate task for RX processing (retransmission decision)
-// . good packets go to RX, bad packets go to FEC first
+// + good packets go to RX, bad packets go to FEC first
 // + packet retransmission and strategy
 // . limit or receive range to minimize false FEC decode
 //
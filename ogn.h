@@ -5,6 +5,7 @@
 
 #include <string.h>
 #include <stdint.h>
+
 #ifndef __AVR__
 #include <time.h>
 #endif
@@ -74,6 +75,62 @@ class OGN_FirmwareByte
                            // nRF905, CC1101, SPIRIT1, RFM69 chips actually reverse the bit order within every byte
                            // thus on the air the bits appear MSbit first for every byte transmitted
 
+// TEA rounds with the all-zero key, which whitens the packets: unrolled at compile time thus every round sum is a constant.
+// always_inline as -Os would otherwise leave the recursion as calls.
+template <int Loop, int Loops>
+ class OGN_TEA_Key0
+{ public:
+   static const uint32_t Delta = 0x9e3779b9;
+
+   __attribute__((always_inline)) static inline void Encrypt(uint32_t &v0, uint32_t &v1)
+   { const uint32_t sum = Delta*(Loop+1);
+     v0 += (v1<<4) ^ (v1 + sum) ^ (v1>>5);
+     v1 += (v0<<4) ^ (v0 + sum) ^ (v0>>5);
+     OGN_TEA_Key0<Loop+1, Loops>::Encrypt(v0, v1); }
+
+   __attribute__((always_inline)) static inline void Decrypt(uint32_t &v0, uint32_t &v1)
+   { const uint32_t sum = Delta*(Loops-Loop);
+     v1 -= (v0<<4) ^ (v0 + sum) ^ (v0>>5);
+     v0 -= (v1<<4) ^ (v1 + sum) ^ (v1>>5);
+     OGN_TEA_Key0<Loop+1, Loops>::Decrypt(v0, v1); }
+} ;
+
+template <int Loops>
+ class OGN_TEA_Key0<Loops, Loops>                         // end of the recursion
+{ public:
+   static inline void Encrypt(uint32_t &, uint32_t &) { }
+   static inline void Decrypt(uint32_t &, uint32_t &) { }
+} ;
+
+class OGN_PacketView       // fields of a received packet decoded once, then used by all the outputs: $POGNT, $PFLAA, MAVLink, relay rank
+{ public:
+   int32_t Latitude;       // [0.0001/60deg]
+   int32_t Longitude;      // [0.0001/60deg]
+   int32_t Altitude;       // [m]
+   int16_t Speed;          // [0.1m/s]
+   int16_t Heading;        // [0.1deg]
+   int16_t ClimbRate;      // [0.1m/s]
+   int16_t TurnRate;       // [0.1deg/s]
+   int32_t LatDist;        // [m] distance vector from the reference (own) position: valid after calcDistance()
+   int32_t LonDist;        // [m]
+    int8_t DistOK;         // result of calcDistance(): negative when too far
+
+  public:
+   // distance vector [LatDist, LonDist] of [Lat, Lon] from a given reference [RefLat, Reflon]
+   static int calcDistanceVector(int32_t &LatDist, int32_t &LonDist, int32_t Lat, int32_t Lon, int32_t RefLat, int32_t RefLon, uint16_t LatCos=3000, int32_t MaxDist=0x7FFF)
+   { LatDist = ((Lat-RefLat)*1517+0x1000)>>13;                        // convert from 1/600000deg to meters (40000000m = 360deg) => x 5/27 = 1517/(1<<13)
+     if(abs(LatDist)>MaxDist) return -1;
+     LonDist = ((Lon-RefLon)*1517+0x1000)>>13;
+     if(abs(LonDist)>(4*MaxDist)) return -1;
+             LonDist = (LonDist*LatCos+0x800)>>12;
+     if(abs(LonDist)>MaxDist) return -1;
+     return 1; }
+
+   int calcDistance(int32_t RefLat, int32_t RefLon, uint16_t LatCos=3000, int32_t MaxDist=0x7FFF)
+   { return DistOK=calcDistanceVector(LatDist, LonDist, Latitude, Longitude, RefLat, RefLon, LatCos, MaxDist); }
+
+} ;
+
 class OGN_Packet           // Packet structure for the OGN tracker
 { public:
 
@@ -244,13 +301,16 @@ class OGN_Packet           // Packet structure for the OGN tracker
    }
 
    void Encode(MAV_ADSB_VEHICLE *MAV)
+   { OGN_PacketView View; Decode(View); Encode(MAV, View); }
+
+   void Encode(MAV_ADSB_VEHICLE *MAV, const OGN_PacketView &View)
    { MAV->ICAO_address = HeaderWord&0x03FFFFFF;
-     MAV->lat      = ((int64_t)50*DecodeLatitude()+1)/3;
-     MAV->lon      = ((int64_t)50*DecodeLongitude()+1)/3;
-     MAV->altitude = 1000*DecodeAltitude();
-     MAV->heading  = 10*DecodeHeading();
-     MAV->hor_velocity = 10*DecodeSpeed();
-     MAV->ver_velocity = 10*DecodeClimbRate();
+     MAV->lat      = ((int64_t)50*View.Latitude+1)/3;
+     MAV->lon      = ((int64_t)50*View.Longitude+1)/3;
+     MAV->altitude = 1000*View.Altitude;
+     MAV->heading  = 10*View.Heading;
+     MAV->hor_velocity = 10*View.Speed;
+     MAV->ver_velocity = 10*View.ClimbRate;
      MAV->flags         = 0x17;
      MAV->altitude_type =    1;
      MAV->callsign[0]   =    0;
@@ -386,13 +446,17 @@ class OGN_Packet           // Packet structure for the OGN tracker
 
    // calculate distance vector [LatDist, LonDist] from a given reference [RefLat, Reflon]
    int calcDistanceVector(int32_t &LatDist, int32_t &LonDist, int32_t RefLat, int32_t RefLon, uint16_t LatCos=3000, int32_t MaxDist=0x7FFF)
-   { LatDist = ((DecodeLatitude()-RefLat)*1517+0x1000)>>13;           // convert from 1/600000deg to meters (40000000m = 360deg) => x 5/27 = 1517/(1<<13)
-     if(abs(LatDist)>MaxDist) return -1;
-     LonDist = ((DecodeLongitude()-RefLon)*1517+0x1000)>>13;
-     if(abs(LonDist)>(4*MaxDist)) return -1;
-             LonDist = (LonDist*LatCos+0x800)>>12;
-     if(abs(LonDist)>MaxDist) return -1;
-     return 1; }
+   { return OGN_PacketView::calcDistanceVector(LatDist, LonDist, DecodeLatitude(), DecodeLongitude(), RefLat, RefLon, LatCos, MaxDist); }
+
+   void Decode(OGN_PacketView &View) const                              // decode the position fields at once, the distance is not set
+   { View.Latitude  = DecodeLatitude();
+     View.Longitude = DecodeLongitude();
+     View.Altitude  = DecodeAltitude();
+     View.Speed     = DecodeSpeed();
+     View.Heading   = DecodeHeading();
+     View.ClimbRate = DecodeClimbRate();
+     View.TurnRate  = DecodeTurnRate();
+     View.DistOK    = -1; }
 
    // sets position [Lat, Lon] according to given distance vector [LatDist, LonDist] from a reference point [RefLat, RefLon]
    void setDistanceVector(int32_t LatDist, int32_t LonDist, int32_t RefLat, int32_t RefLon, uint16_t LatCos=3000)
@@ -424,31 +488,41 @@ class OGN_Packet           // Packet structure for the OGN tracker
      return WritePFLAA(NMEA, Status, LatDist, LonDist, AltDist, Status); }                            // return number of formatted characters
 
    uint8_t WritePFLAA(char *NMEA, uint8_t Status, int32_t LatDist, int32_t LonDist, int32_t AltDist)
+   { OGN_PacketView View; Decode(View);
+     View.LatDist=LatDist; View.LonDist=LonDist;
+     return WritePFLAA(NMEA, Status, View, AltDist); }
+
+   uint8_t WritePFLAA(char *NMEA, uint8_t Status, const OGN_PacketView &View, int32_t AltDist) // View with the distance vector already calculated
+   { return WritePFLAA(NMEA, Status, View, AltDist, Header.AddrType, Header.Address, Position.AcftType); }
+
+   // the standard FLARM fields only: an extrapolated (not received) position is marked by a separate sentence, see $POGNP in proc.cpp
+   static uint8_t WritePFLAA(char *NMEA, uint8_t Status, const OGN_PacketView &View, int32_t AltDist,
+                             uint8_t AddrType, uint32_t Addr, uint8_t AcftType)
    { uint8_t Len=0;
      Len+=Format_String(NMEA+Len, "$PFLAA,");                    // sentence name and alarm-level (but no alarms for trackers)
      NMEA[Len++]='0'+Status;
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, LatDist);
+     Len+=Format_SignDec(NMEA+Len, View.LatDist);
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, LonDist);
+     Len+=Format_SignDec(NMEA+Len, View.LonDist);
      NMEA[Len++]=',';
      Len+=Format_SignDec(NMEA+Len, AltDist);                       // [m] relative altitude
      NMEA[Len++]=',';
-     NMEA[Len++]='0'+Header.AddrType;                              // address-type (3=OGN)
+     NMEA[Len++]='0'+AddrType;                                     // address-type (3=OGN)
      NMEA[Len++]=',';
-     uint32_t Addr = Header.Address;                               // [24-bit] address
+     Addr&=0x00FFFFFF;                                             // [24-bit] address
      Len+=Format_Hex(NMEA+Len, (uint8_t)(Addr>>16));               // XXXXXX 24-bit address: RND, ICAO, FLARM, OGN
      Len+=Format_Hex(NMEA+Len, (uint16_t)Addr);
      NMEA[Len++]=',';
-     Len+=Format_UnsDec(NMEA+Len, DecodeHeading(), 4, 1);          // [deg] heading (by GPS)
+     Len+=Format_UnsDec(NMEA+Len, View.Heading, 4, 1);             // [deg] heading (by GPS)
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, DecodeTurnRate(), 2, 1);        // [deg/sec] turn rate
+     Len+=Format_SignDec(NMEA+Len, View.TurnRate, 2, 1);           // [deg/sec] turn rate
      NMEA[Len++]=',';
-     Len+=Format_UnsDec(NMEA+Len, DecodeSpeed(), 2, 1);            // [approx. m/s] ground speed
+     Len+=Format_UnsDec(NMEA+Len, View.Speed, 2, 1);               // [approx. m/s] ground speed
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, DecodeClimbRate(), 2, 1);       // [m/s] climb/sink rate
+     Len+=Format_SignDec(NMEA+Len, View.ClimbRate, 2, 1);          // [m/s] climb/sink rate
      NMEA[Len++]=',';
-     NMEA[Len++]=HexDigit(Position.AcftType);                      // [0..F] aircraft-type: 1=glider, 2=tow plane, etc.
+     NMEA[Len++]=HexDigit(AcftType);                               // [0..F] aircraft-type: 1=glider, 2=tow plane, etc.
      Len+=NMEA_AppendCheckCRNL(NMEA, Len);
      NMEA[Len]=0;
      return Len; }                                                 // return number of formatted characters
@@ -517,75 +591,51 @@ class OGN_Packet           // Packet structure for the OGN tracker
    void EncodeStdAltitude(int32_t StdAlt) { setBaroAltDiff((StdAlt-DecodeAltitude())); }
    int32_t DecodeStdAltitude(void) const { return (DecodeAltitude()+getBaroAltDiff()); }
 
-   static uint16_t EncodeUR2V8(uint16_t Value)                                 // Encode unsigned 12bit (0..3832) as 10bit
-   {      if(Value<0x100) { }
-     else if(Value<0x300) Value = 0x100 | ((Value-0x100)>>1);
-     else if(Value<0x700) Value = 0x200 | ((Value-0x300)>>2);
-     else if(Value<0xF00) Value = 0x300 | ((Value-0x700)>>3);
-     else                 Value = 0x3FF;
-     return Value; }
-
-   static uint16_t DecodeUR2V8(uint16_t Value)                                 // Decode 10bit 0..0x3FF
-   { uint16_t  Range = Value>>8;
-     Value &= 0x0FF;
-     if(Range==0) return Value;              // 000..0FF
-     if(Range==1) return 0x101+(Value<<1);   // 100..2FE
-     if(Range==2) return 0x302+(Value<<2);   // 300..6FC
-     return 0x704+(Value<<3); }              // 700..EF8                       // in 12bit (0..3832)
-
-   static uint8_t EncodeUR2V5(uint16_t Value)                                  // Encode unsigned 9bit (0..472) as 7bit
-   {      if(Value<0x020) { }
-     else if(Value<0x060) Value = 0x020 | ((Value-0x020)>>1);
-     else if(Value<0x0E0) Value = 0x040 | ((Value-0x060)>>2);
-     else if(Value<0x1E0) Value = 0x060 | ((Value-0x0E0)>>3);
-     else                 Value = 0x07F;
-     return Value; }
-
-   static uint16_t DecodeUR2V5(uint16_t Value)                                 // Decode 7bit as unsigned 9bit (0..472)
-   { uint8_t Range = (Value>>5)&0x03;
-             Value &= 0x1F;
-          if(Range==0) { }                            // 000..01F
-     else if(Range==1) { Value = 0x021+(Value<<1); }  // 020..05E
-     else if(Range==2) { Value = 0x062+(Value<<2); }  // 060..0DC
-     else              { Value = 0x0E4+(Value<<3); }  // 0E0..1D8 => max. Value = 472
-     return Value; }
-
-   static uint8_t EncodeSR2V5(int16_t Value)                                  // Encode signed 10bit (-472..+472) as 8bit
-   { uint8_t Sign=0; if(Value<0) { Value=(-Value); Sign=0x80; }
-     Value = EncodeUR2V5(Value);
-     return Value | Sign; }
-
-   static  int16_t DecodeSR2V5( int16_t Value)                                // Decode
-   { int16_t Sign =  Value&0x80;
-     Value = DecodeUR2V5(Value&0x7F);
-     return Sign ? -Value: Value; }
-
-   static uint16_t EncodeUR2V6(uint16_t Value)                                // Encode unsigned 10bit (0..952) as 8 bit
-   {      if(Value<0x040) { }
-     else if(Value<0x0C0) Value = 0x040 | ((Value-0x040)>>1);
-     else if(Value<0x1C0) Value = 0x080 | ((Value-0x0C0)>>2);
-     else if(Value<0x3C0) Value = 0x0C0 | ((Value-0x1C0)>>3);
-     else                 Value = 0x0FF;
-     return Value; }
-
-   static uint16_t DecodeUR2V6(uint16_t Value)                                // Decode 8bit as unsigned 10bit (0..952)
-   { uint16_t Range  = (Value>>6)&0x03;
-             Value &= 0x3F;
-          if(Range==0) { }                            // 000..03F
-     else if(Range==1) { Value = 0x041+(Value<<1); }  // 040..0BE
-     else if(Range==2) { Value = 0x0C2+(Value<<2); }  // 0C0..1BC
-     else              { Value = 0x1C4+(Value<<3); }  // 1C0..3B8 => max. Value = 952
-     return Value; }
-
-   static uint16_t EncodeSR2V6(int16_t Value)                                 // Encode signed 11bit (-952..+952) as 9bit
-   { uint16_t Sign=0; if(Value<0) { Value=(-Value); Sign=0x100; }
-     Value = EncodeUR2V6(Value);
-     return Value | Sign; }
-
-   static  int16_t DecodeSR2V6( int16_t Value)                                // Decode 9bit as signed 11bit (-952..+952)
-   { int16_t Sign =  Value&0x100;
-     Value = DecodeUR2V6(Value&0x00FF);
-     return Sign ? -Value: Value; }
+   // UR2V<Bits>: unsigned value in four ranges of 2^Bits steps each, the steps being 1, 2, 4 and 8,
+   // thus 2^Bits*15-1 is the largest value to encode into Bits+2 bits; larger values saturate to all-ones.
+   // Branch-free: the range is the position of the highest bit of Value+2^Bits (a single CLZ on ARM).
+   template <int Bits>
+    static uint16_t EncodeUR2V(uint16_t Value)
+   { const uint32_t Mant = (uint32_t)1<<Bits;
+     uint32_t Val = Value;
+     if(Val>(15*Mant-1)) Val=15*Mant-1;                                       // saturate => 0x3FF for Bits=8
+     Val += Mant;                                                             // now Mant..16*Mant-1
+     int Range = 31-__builtin_clz(Val)-Bits;                                  // 0..3
+     return (Val>>Range) + ((uint32_t)Range<<Bits) - Mant; }                  // (Range<<Bits) | ((Value-Mant*(2^Range-1))>>Range)
+
+   template <int Bits>
+    static uint16_t DecodeUR2V(uint16_t Value)                                // middle of the step, like 0x101+(Value<<1) for Range=1
+   { const uint32_t Mant = (uint32_t)1<<Bits;
+     int Range = (Value>>Bits)&3;
+     uint32_t Val = Mant + (Value&(Mant-1));
+     return (Val<<Range) - Mant + (((uint32_t)1<<Range)>>1); }
+
+   template <int Bits>
+    static uint16_t EncodeSR2V(int16_t Value)                                 // sign at bit Bits+2, magnitude as UR2V<Bits>
+   { int32_t Sign = Value>>15;                                                // 0 or -1
+     uint16_t Abs = (uint16_t)((Value^Sign)-Sign);                            // -32768 gives 32768 which saturates
+     return EncodeUR2V<Bits>(Abs) | ((uint16_t)(Sign&1)<<(Bits+2)); }
+
+   template <int Bits>
+    static  int16_t DecodeSR2V(uint16_t Value)
+   { int16_t Sign = -(int16_t)((Value>>(Bits+2))&1);                          // 0 or -1
+     int16_t Abs  = DecodeUR2V<Bits>(Value&((4<<Bits)-1));
+     return (Abs^Sign)-Sign; }
+
+   static uint16_t EncodeUR2V8(uint16_t Value) { return EncodeUR2V<8>(Value); }  // Encode unsigned 12bit (0..3832) as 10bit
+   static uint16_t DecodeUR2V8(uint16_t Value) { return DecodeUR2V<8>(Value); }  // Decode 10bit 0..0x3FF
+
+   static uint8_t  EncodeUR2V5(uint16_t Value) { return EncodeUR2V<5>(Value); }  // Encode unsigned 9bit (0..472) as 7bit
+   static uint16_t DecodeUR2V5(uint16_t Value) { return DecodeUR2V<5>(Value); }  // Decode 7bit as unsigned 9bit (0..472)
+
+   static uint8_t  EncodeSR2V5( int16_t Value) { return EncodeSR2V<5>(Value); }  // Encode signed 10bit (-472..+472) as 8bit
+   static  int16_t DecodeSR2V5( int16_t Value) { return DecodeSR2V<5>(Value); }  // Decode
+
+   static uint16_t EncodeUR2V6(uint16_t Value) { return EncodeUR2V<6>(Value); }  // Encode unsigned 10bit (0..952) as 8 bit
+   static uint16_t DecodeUR2V6(uint16_t Value) { return DecodeUR2V<6>(Value); }  // Decode 8bit as unsigned 10bit (0..952)
+
+   static uint16_t EncodeSR2V6( int16_t Value) { return EncodeSR2V<6>(Value); }  // Encode signed 11bit (-952..+952) as 9bit
+   static  int16_t DecodeSR2V6( int16_t Value) { return DecodeSR2V<6>(Value); }  // Decode 9bit as signed 11bit (-952..+952)
 
    void EncodeLatitude(int32_t Latitude)                                // encode Latitude: units are 0.0001/60 degrees
    { Position.Latitude = Latitude>>3; }
@@ -603,21 +653,8 @@ class OGN_Packet           // Packet structure for the OGN tracker
      // if(Longitude&0x00800000) Longitude|=0xFF000000;
      Longitude = (Longitude<<4)+8; return Longitude; }
 
-   static uint16_t EncodeUR2V12(uint16_t Value)                        // encode unsigned 16-bit (0..61432) as 14-bit
-   {      if(Value<0x1000) { }
-     else if(Value<0x3000) Value = 0x1000 | ((Value-0x1000)>>1);
-     else if(Value<0x7000) Value = 0x2000 | ((Value-0x3000)>>2);
-     else if(Value<0xF000) Value = 0x3000 | ((Value-0x7000)>>3);
-     else                  Value = 0x3FFF;
-     return Value; }
-
-   static uint16_t DecodeUR2V12(uint16_t Value)
-   { uint16_t Range = Value>>12;
-              Value &=0x0FFF;
-     if(Range==0) return         Value;       // 0000..0FFF
-     if(Range==1) return 0x1001+(Value<<1);   // 1000..2FFE
-     if(Range==2) return 0x3002+(Value<<2);   // 3000..6FFC
-     return 0x7004+(Value<<3); }              // 7000..EFF8 => max: 61432
+   static uint16_t EncodeUR2V12(uint16_t Value) { return EncodeUR2V<12>(Value); } // encode unsigned 16-bit (0..61432) as 14-bit
+   static uint16_t DecodeUR2V12(uint16_t Value) { return DecodeUR2V<12>(Value); }
 
    void EncodeAltitude(int32_t Altitude)                               // encode altitude in meters
    { if(Altitude<0)      Altitude=0;
@@ -627,22 +664,10 @@ class OGN_Packet           // Packet structure for the OGN tracker
    { return DecodeUR2V12(Position.Altitude); }
 
    void EncodeDOP(uint8_t DOP)
-   { // if(DOP<0)    DOP=0;
-          if(DOP<0x10) { }
-     else if(DOP<0x30) DOP = 0x10 | ((DOP-0x10)>>1);
-     else if(DOP<0x70) DOP = 0x20 | ((DOP-0x30)>>2);
-     else if(DOP<0xF0) DOP = 0x30 | ((DOP-0x70)>>3);
-     else              DOP = 0x3F;
-     Position.DOP = DOP; }
-
-   uint8_t DecodeDOP(void) const
-   { uint8_t DOP = Position.DOP;
-     uint8_t Range = DOP>>4;
-     DOP &= 0x0F;
-     if(Range==0) return       DOP;              // 00..0F
-     if(Range==1) return 0x11+(DOP<<1);          // 10..2E
-     if(Range==2) return 0x32+(DOP<<2);          // 30..6C
-     return 0x74+(DOP<<3); }                     // 70..E8 => max. DOP = 232*0.1=23.2
+   { Position.DOP = EncodeUR2V<4>(DOP); }
+
+   uint8_t DecodeDOP(void) const                 // 00..E8 => max. DOP = 232*0.1=23.2
+   { return DecodeUR2V<4>(Position.DOP); }
 
    void EncodeSpeed(int16_t Speed)                                       // speed in 0.2 knots (or 0.1m/s)
    {      if(Speed<0)     Speed=0;
@@ -725,8 +750,9 @@ class OGN_Packet           // Packet structure for the OGN tracker
 
    // void Whiten  (void) { TEA_Encrypt(Position, OGN_WhitenKey, 4); TEA_Encrypt(Position+2, OGN_WhitenKey, 4); } // whiten the position
    // void Dewhiten(void) { TEA_Decrypt(Position, OGN_WhitenKey, 4); TEA_Decrypt(Position+2, OGN_WhitenKey, 4); } // de-whiten the position
-   void Whiten  (void) { TEA_Encrypt_Key0(Data, 8); TEA_Encrypt_Key0(Data+2, 8); } // whiten the position
-   void Dewhiten(void) { TEA_Decrypt_Key0(Data, 8); TEA_Decrypt_Key0(Data+2, 8); } // de-whiten the position
+   static const int WhitenLoops = 8;
+   void Whiten  (void) { TEA_Encrypt_Key0<WhitenLoops>(Data); TEA_Encrypt_Key0<WhitenLoops>(Data+2); } // whiten the position
+   void Dewhiten(void) { TEA_Decrypt_Key0<WhitenLoops>(Data); TEA_Decrypt_Key0<WhitenLoops>(Data+2); } // de-whiten the position
 
    static void TEA_Encrypt (uint32_t* Data, const uint32_t *Key, int Loops=4)
    { uint32_t v0=Data[0], v1=Data[1];                         // set up
@@ -770,6 +796,18 @@ class OGN_Packet           // Packet structure for the OGN tracker
      Data[0]=v0; Data[1]=v1;
    }
 
+   template <int Loops>
+    static void TEA_Encrypt_Key0 (uint32_t* Data)             // same as above with Loops known at compile time: unrolled
+   { uint32_t v0=Data[0], v1=Data[1];
+     OGN_TEA_Key0<0, Loops>::Encrypt(v0, v1);
+     Data[0]=v0; Data[1]=v1; }
+
+   template <int Loops>
+    static void TEA_Decrypt_Key0 (uint32_t* Data)
+   { uint32_t v0=Data[0], v1=Data[1];
+     OGN_TEA_Key0<0, Loops>::Decrypt(v0, v1);
+     Data[0]=v0; Data[1]=v1; }
+
    static uint8_t Gray(uint8_t Binary) { return Binary ^ (Binary>>1); }
 
    static uint8_t Binary(uint8_t Gray)
@@ -841,6 +879,11 @@ class OGN_TxPacket                                    // OGN packet with FEC cod
    void    calcFEC(void)                   { LDPC_Encode(Packet.Word()); }       // calculate the 48-bit parity check
    uint8_t checkFEC(void)    const  { return LDPC_Check(Packet.Word()); }        // returns number of parity checks that fail (0 => no errors, all fine)
 
+   void incrRelayCount(uint8_t Incr=1)                                         // on a whitened packet with valid FEC: the header is not whitened
+   { uint32_t Prev=Packet.HeaderWord;                                          // and the code is linear, thus only the parity bits
+     Packet.Header.RelayCount+=Incr;                                           // of the changed header bits need to be flipped
+     LDPC_PatchHeader(FEC, Prev^Packet.HeaderWord); }
+
    uint8_t  *Byte(void) const { return (uint8_t  *)&Packet.HeaderWord; } // packet as bytes
    uint32_t *Word(void) const { return (uint32_t *)&Packet.HeaderWord; } // packet as words
 
@@ -921,6 +964,10 @@ class OGN_RxPacket                                        // OGN packet with FEC
            +Count1s((FEC[1]^RefPacket.FEC[1])&0xFFFF); }
 
    void calcRelayRank(int32_t RxAltitude)                               // [0.1m] altitude of reception
+   { OGN_PacketView View; View.Altitude=Packet.DecodeAltitude(); View.ClimbRate=Packet.DecodeClimbRate();
+     calcRelayRank(RxAltitude, View); }
+
+   void calcRelayRank(int32_t RxAltitude, const OGN_PacketView &View)
    { if(Packet.Header.Emergency) { Rank=0xFF; return; }                 // emergency packets always highest rank
      Rank=0;
      if(Packet.Header.Other) return;                                    // only relay position packets
@@ -928,10 +975,10 @@ class OGN_RxPacket                                        // OGN packet with FEC
      if(Packet.Header.RelayCount>0) return;                             // no rank for relayed packets (only single relay)
      if(RxRSSI>128)                                                     // [-0.5dB] weaker signal => higher rank
        Rank += (RxRSSI-128)>>2;                                         // 1point/2dB less signal
-     RxAltitude -= 10*Packet.DecodeAltitude();                          // [0.1m] lower altitude => higher rank
+     RxAltitude -= 10*View.Altitude;                                    // [0.1m] lower altitude => higher rank
      if(RxAltitude>0)
        Rank += RxAltitude>>9;                                           // 2points/100m of altitude below
-     int16_t ClimbRate = Packet.DecodeClimbRate();                      // [0.1m/s] higher sink rate => higher rank
+     int16_t ClimbRate = View.ClimbRate;                                // [0.1m/s] higher sink rate => higher rank
      if(ClimbRate<0)
        Rank += (-ClimbRate)>>3;                                         // 1point/0.8m/s of sink
    }
@@ -1063,6 +1110,10 @@ class OGN_RxPacket                                        // OGN packet with FEC
      return Len; }
 
    uint8_t WritePOGNT(char *NMEA)
+   { OGN_PacketView View; Packet.Decode(View);
+     return WritePOGNT(NMEA, View); }
+
+   uint8_t WritePOGNT(char *NMEA, const OGN_PacketView &View)
    { uint8_t Len=0;
      Len+=Format_String(NMEA+Len, "$POGNT,");                             // sentence name
      if(Packet.Position.Time<60)
@@ -1083,22 +1134,22 @@ class OGN_RxPacket                                        // OGN packet with FEC
      NMEA[Len++]=',';
      Len+=Format_UnsDec(NMEA+Len, (uint16_t)(Packet.DecodeDOP()+10),2,1); // [] Dilution of Precision
      NMEA[Len++]=',';
-     Len+=Packet.PrintLatitude(NMEA+Len, Packet.DecodeLatitude());        // [] Latitude
+     Len+=Packet.PrintLatitude(NMEA+Len, View.Latitude);                // [] Latitude
      NMEA[Len++]=',';
-     Len+=Packet.PrintLongitude(NMEA+Len, Packet.DecodeLongitude());      // [] Longitude
+     Len+=Packet.PrintLongitude(NMEA+Len, View.Longitude);              // [] Longitude
      NMEA[Len++]=',';
-     Len+=Format_UnsDec(NMEA+Len, (uint32_t)Packet.DecodeAltitude());     // [m] Altitude (by GPS)
+     Len+=Format_UnsDec(NMEA+Len, (uint32_t)View.Altitude);               // [m] Altitude (by GPS)
      NMEA[Len++]=',';
      if(Packet.hasBaro())
        Len+=Format_SignDec(NMEA+Len, (int32_t)Packet.getBaroAltDiff());   // [m] Standard Pressure Altitude (by Baro)
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, Packet.DecodeClimbRate(), 2, 1);       // [m/s] climb/sink rate (by GPS or pressure sensor)
+     Len+=Format_SignDec(NMEA+Len, View.ClimbRate, 2, 1);                 // [m/s] climb/sink rate (by GPS or pressure sensor)
      NMEA[Len++]=',';
-     Len+=Format_UnsDec(NMEA+Len, Packet.DecodeSpeed(), 2, 1);         // [m/s] ground speed (by GPS)
+     Len+=Format_UnsDec(NMEA+Len, View.Speed, 2, 1);                   // [m/s] ground speed (by GPS)
      NMEA[Len++]=',';
-     Len+=Format_UnsDec(NMEA+Len, Packet.DecodeHeading(), 4, 1);          // [deg] heading (by GPS)
+     Len+=Format_UnsDec(NMEA+Len, View.Heading, 4, 1);                    // [deg] heading (by GPS)
      NMEA[Len++]=',';
-     Len+=Format_SignDec(NMEA+Len, Packet.DecodeTurnRate(), 2, 1);         // [deg/s] turning rate (by GPS)
+     Len+=Format_SignDec(NMEA+Len, View.TurnRate, 2, 1);                   // [deg/s] turning rate (by GPS)
      NMEA[Len++]=',';
      Len+=Format_SignDec(NMEA+Len, -(int16_t)RxRSSI/2);            // [dBm] received signal level
      NMEA[Len++]=',';
@@ -1216,14 +1267,15 @@ template<uint8_t Size=8>
  class OGN_PrioQueue
 { public:
    // static const uint8_t Size = 8;            // number of packets kept
-   OGN_RxPacket         Packet[Size];        // OGN packets
+   OGN_RxPacket         Packet[Size];        // OGN packets: kept whitened with valid FEC, ready for transmission
+   uint8_t              Time[Size];          // [sec] position time of every packet, as the whitened packet does not tell it
    uint16_t             Sum;                 // sum of all ranks
    uint8_t              Low, LowIdx;         // the lowest rank and the index of it
 
   public:
    void Clear(void)                                                           // clear (reset) the queue
    { for(uint8_t Idx=0; Idx<Size; Idx++)                                      // clear every packet
-     { Packet[Idx].Clear(); }
+     { Packet[Idx].Clear(); Time[Idx]=0; }
      Sum=0; Low=0; LowIdx=0; }                                                // clear the rank sum, lowest rank
 
    OGN_RxPacket * operator [](uint8_t Idx) { return Packet+Idx; }
@@ -1231,8 +1283,9 @@ template<uint8_t Size=8>
    uint8_t getNew(void)                                                       // get (index of) a free or lowest rank packet
    { Sum-=Packet[LowIdx].Rank; Packet[LowIdx].Rank=0; Low=0; return LowIdx; } // remove old packet from the rank sum
 
-   void addNew(uint8_t NewIdx)                                                // add the new packet to the queue
-   { uint32_t AddressAndType = Packet[NewIdx].Packet.getAddressAndType();     // get ID of this packet: ID is address-type and address (2+24 = 26 bits)
+   void addNew(uint8_t NewIdx, uint8_t NewTime)                               // add the new packet to the queue
+   { Time[NewIdx]=NewTime;
+     uint32_t AddressAndType = Packet[NewIdx].Packet.getAddressAndType();     // get ID of this packet: ID is address-type and address (2+24 = 26 bits)
      for(uint8_t Idx=0; Idx<Size; Idx++)                                      // look for other packets with same ID
      { if(Idx==NewIdx) continue;                                              // avoid the new packet
        if(Packet[Idx].Packet.getAddressAndType() == AddressAndType)           // if another packet with same ID:
@@ -1264,9 +1317,9 @@ template<uint8_t Size=8>
      }
    }
 
-   void cleanTime(uint8_t Time)                                                // clean up slots of given Time
+   void cleanTime(uint8_t OldTime)                                             // clean up slots of given Time
    { for(int Idx=0; Idx<Size; Idx++)
-     { if( (Packet[Idx].Rank) && (Packet[Idx].Packet.Position.Time==Time) )
+     { if( (Packet[Idx].Rank) && (Time[Idx]==OldTime) )
        { clean(Idx); }
      }
    }
@@ -1288,7 +1341,7 @@ template<uint8_t Size=8>
        Out[Len++]=' '; Len+=Format_Hex(Out+Len, Rank);
        if(Rank)
        { Out[Len++]='/'; Len+=Format_Hex(Out+Len, Packet[Idx].Packet.getAddressAndType() );
-         Out[Len++]=':'; Len+=Format_UnsDec(Out+Len, Packet[Idx].Packet.Position.Time, 2 ); }
+         Out[Len++]=':'; Len+=Format_UnsDec(Out+Len, Time[Idx], 2 ); }
      }
      Out[Len++]=' '; Len+=Format_Hex(Out+Len, Sum);
      Out[Len++]='/'; Len+=Format_Hex(Out+Len, LowIdx);
@@ -1296,6 +1349,150 @@ template<uint8_t Size=8>
 
 } ;
 
+template <bool Wide> struct OGN_QueueIndex       { typedef uint8_t  Type; }; // slot index type: no <type_traits> on AVR
+template <>          struct OGN_QueueIndex<true>  { typedef uint16_t Type; };
+
+// same function as OGN_PrioQueue but the operations do not scan the whole queue thus it can keep many more packets:
+// packets with the same address are found by a hash, the weighted random pick and the lowest rank are found
+// in a binary tree of the ranks (every node keeps the sum of the ranks and the lowest-rank slot below it)
+// and the packets are filed on a time wheel: one list per second of the position time, thus the expiry of the packets
+// of a given second only drains one list, the cost is given by the number of expired packets, not the queue size.
+// Size must be a power of two: 2*Size bytes for the rank sums, 6-7 bytes per slot more than OGN_PrioQueue.
+
+template<uint16_t Size=32>
+ class OGN_IndexPrioQueue
+{ public:
+   typedef typename OGN_QueueIndex<(Size>128)>::Type Index;
+   static_assert( (Size>=2) && ((Size&(Size-1))==0), "OGN_IndexPrioQueue: Size must be a power of two");
+   static const Index  Nil = (Index)(~0);     // end of a list
+   static const uint8_t NoTime = 0xFF;        // slot not on the lists (free)
+   static const int     HashBits = __builtin_ctz(Size);
+
+   OGN_RxPacket         Packet[Size];        // OGN packets: kept whitened with valid FEC, ready for transmission
+   uint8_t              Time[Size];          // [sec] position time of every packet, as the whitened packet does not tell it
+   uint16_t             RankSum[2*Size];     // [1] = sum of all ranks, [Size+Idx] = rank of slot Idx
+   Index                LowIdx[Size];        // [1] = slot with the lowest rank, [Node] = the lowest rank slot below Node
+   Index                HashHead[Size];      // lists of slots by the address hash
+   Index                HashNext[Size];
+   static const uint8_t Wheel = 60;          // [sec] time wheel: one list per second
+   Index                TimeHead[Wheel];     // lists of slots by the position time
+   Index                TimeNext[Size], TimePrev[Size];
+
+  public:
+   void Clear(void)                                                           // clear (reset) the queue
+   { for(uint16_t Idx=0; Idx<Size; Idx++)
+     { Packet[Idx].Clear(); Time[Idx]=NoTime; HashHead[Idx]=Nil; }
+     for(uint8_t Sec=0; Sec<Wheel; Sec++) TimeHead[Sec]=Nil;
+     reCalc(); }
+
+   OGN_RxPacket * operator [](Index Idx) { return Packet+Idx; }
+
+   uint16_t getSum(void) const { return RankSum[1]; }                         // sum of all ranks
+   Index    getLow(void) const { return LowIdx[1]; }                          // slot with the lowest rank
+
+   Index getNew(void)                                                         // get (index of) a free or lowest rank packet
+   { Index Idx=getLow(); clean(Idx); return Idx; }
+
+   void addNew(Index NewIdx, uint8_t NewTime)                                 // add the new packet to the queue, NewIdx from getNew(), NewTime = 0..59 [sec]
+   { uint32_t AddressAndType = Packet[NewIdx].Packet.getAddressAndType();     // get ID of this packet: ID is address-type and address (2+24 = 26 bits)
+     Index Idx=HashHead[Hash(AddressAndType)];
+     while(Idx!=Nil)                                                          // look for other packets with same ID
+     { Index Next=HashNext[Idx];
+       if( (Idx!=NewIdx) && (Packet[Idx].Packet.getAddressAndType()==AddressAndType) ) clean(Idx); // then remove it
+       Idx=Next; }
+     Link(NewIdx, NewTime);
+     Update(NewIdx); }
+
+   Index Find(uint32_t AddressAndType) const                                  // slot with the packet of given ID or Nil
+   { Index Idx=HashHead[Hash(AddressAndType)];
+     for( ; Idx!=Nil; Idx=HashNext[Idx])
+       if(Packet[Idx].Packet.getAddressAndType()==AddressAndType) break;
+     return Idx; }
+
+   // another tracker relayed a packet (RelayCount>0) of an aircraft we hold: remove our packet of that aircraft.
+   // Queuing the relayed copy ends the same way, as it has zero rank and addNew() replaces our packet,
+   // thus this only saves the queue slot of the copy and lets proc.cpp count such relays for $POGNR.
+   // Returns true when we held the aircraft, the relayed copy should then not be queued.
+   bool overheardRelay(uint32_t AddressAndType)
+   { Index Idx=Find(AddressAndType); if(Idx==Nil) return 0;
+     clean(Idx); return 1; }
+
+   Index getRand(uint32_t Rand) const                                         // get a position by random selection but probabilities prop. to ranks
+   { if(RankSum[1]==0) return Rand%Size;
+     uint16_t RankIdx = Rand%RankSum[1];
+     uint16_t Node=1;
+     while(Node<Size)                                                         // walk down the tree
+     { Node<<=1;
+       if(RankIdx>=RankSum[Node]) { RankIdx-=RankSum[Node]; Node++; } }       // into the right branch
+     return Node-Size; }
+
+   void reCalc(void)                                                          // rebuild the tree of ranks
+   { for(uint16_t Idx=0; Idx<Size; Idx++) RankSum[Size+Idx]=Packet[Idx].Rank;
+     for(uint16_t Node=Size-1; Node>0; Node--) calcNode(Node); }
+
+   void cleanTime(uint8_t OldTime)                                            // clean up slots of given Time: drain its list
+   { Index *Head=TimeHead+(OldTime%Wheel);
+     while(*Head!=Nil) clean(*Head); }                                        // clean() takes the slot off the list
+
+   void clean(Index Idx)                                                      // clean given slot
+   { Unlink(Idx); Packet[Idx].Rank=0; Update(Idx); }
+
+   void decrRank(Index Idx, uint8_t Decr=1)                                   // decrement rank of given slot
+   { uint8_t Rank=Packet[Idx].Rank; if(Rank==0) return;                       // if zero already: do nothing
+     if(Decr>Rank) Decr=Rank;                                                 // if to decrement by more than the rank already: reduce the decrement
+     Packet[Idx].Rank=Rank-Decr; Update(Idx); }
+
+   uint8_t Print(char *Out, uint8_t MaxLen=112)                               // MaxLen: the queue can be longer than a console line
+   { uint8_t Len=0;
+     for(uint16_t Idx=0; Idx<Size; Idx++)
+     { uint8_t Rank=Packet[Idx].Rank;
+       if(Rank==0) continue;                                                  // only the occupied slots
+       if(Len+16+12>MaxLen) { Out[Len++]=' '; Out[Len++]='.'; Out[Len++]='.'; break; }
+       Out[Len++]=' '; Len+=Format_Hex(Out+Len, Rank);
+       Out[Len++]='/'; Len+=Format_Hex(Out+Len, Packet[Idx].Packet.getAddressAndType() );
+       Out[Len++]=':'; Len+=Format_UnsDec(Out+Len, Time[Idx], 2 );
+       }
+     Out[Len++]=' '; Len+=Format_Hex(Out+Len, getSum());
+     Out[Len++]='/'; Len+=Format_Hex(Out+Len, (uint16_t)getLow());
+     Out[Len++]='\n'; Out[Len]=0; return Len; }
+
+  private:
+   static uint16_t Hash(uint32_t AddressAndType)                              // multiplicative hash: the top bits are well mixed
+   { return (AddressAndType*0x9E3779B1)>>(32-HashBits); }
+
+   Index nodeLow(uint16_t Node) const { return Node>=Size ? Node-Size:LowIdx[Node]; }
+
+   void calcNode(uint16_t Node)
+   { uint16_t Left=Node<<1;
+     RankSum[Node] = RankSum[Left]+RankSum[Left+1];
+     Index LeftLow=nodeLow(Left), RightLow=nodeLow(Left+1);
+     LowIdx[Node] = Packet[RightLow].Rank<Packet[LeftLow].Rank ? RightLow:LeftLow; }
+
+   void Update(Index Idx)                                                     // rank of Idx changed: update the path to the root
+   { uint16_t Node=Size+Idx;
+     RankSum[Node]=Packet[Idx].Rank;
+     for(Node>>=1; Node>0; Node>>=1) calcNode(Node); }
+
+   void Link(Index Idx, uint8_t NewTime)                                      // put the slot on the address and time lists
+   { uint16_t Bucket=Hash(Packet[Idx].Packet.getAddressAndType());
+     HashNext[Idx]=HashHead[Bucket]; HashHead[Bucket]=Idx;
+     NewTime%=Wheel; Time[Idx]=NewTime;
+     TimePrev[Idx]=Nil; TimeNext[Idx]=TimeHead[NewTime];
+     if(TimeHead[NewTime]!=Nil) TimePrev[TimeHead[NewTime]]=Idx;
+     TimeHead[NewTime]=Idx; }
+
+   void Unlink(Index Idx)                                                     // take the slot off the lists
+   { if(Time[Idx]==NoTime) return;
+     Index *Ptr=HashHead+Hash(Packet[Idx].Packet.getAddressAndType());        // the address lists are short: walk it
+     while(*Ptr!=Idx) Ptr=HashNext+(*Ptr);
+     *Ptr=HashNext[Idx];
+     Index Prev=TimePrev[Idx], Next=TimeNext[Idx];
+     if(Prev!=Nil) TimeNext[Prev]=Next; else TimeHead[Time[Idx]]=Next;
+     if(Next!=Nil) TimePrev[Next]=Prev;
+     Time[Idx]=NoTime; }
+
+} ;
+
 class GPS_Position
 { public:
 
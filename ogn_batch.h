@@ -0,0 +1,75 @@
+#ifndef __OGN_BATCH_H__
+#define __OGN_BATCH_H__
+
+// Host-only (ground station, log re-processing) batch whitening/de-whitening of OGN packets:
+// the same key-0 TEA as OGN_Packet::Whiten()/Dewhiten() but on several packets at once, one packet per SIMD lane.
+// Uses the GCC vector extensions like ldpc_batch.h: compile with -msse2 or -mavx2 (or -march=native) to get the speed-up.
+// The results are bit-exact with OGN_Packet::Whiten()/Dewhiten(): same 32-bit arithmetic.
+
+#include <stdint.h>
+
+#include "ogn.h"
+
+template <int Lanes=8>                                     // 4, 8 or 16 packets processed in parallel
+ class OGN_WhitenBatch
+{ public:
+   static const int VectBytes = 4*Lanes;
+   typedef uint32_t Vect __attribute__ ((vector_size (VectBytes))); // one word of the packets
+
+   static const uint32_t Delta = 0x9e3779b9;
+   static const int      Loops = OGN_Packet::WhitenLoops;
+
+  private:
+
+   static uint32_t &Elem(Vect &Word, int Lane) { return ((uint32_t *)&Word)[Lane]; } // single lane, like LDPC_BatchDecoder::Elem()
+
+   static void Encrypt(Vect &v0, Vect &v1)
+   { uint32_t sum=0;
+     for(int Loop=0; Loop<Loops; Loop++)
+     { sum += Delta;
+       v0 += (v1<<4) ^ (v1 + sum) ^ (v1>>5);
+       v1 += (v0<<4) ^ (v0 + sum) ^ (v0>>5); }
+   }
+
+   static void Decrypt(Vect &v0, Vect &v1)
+   { uint32_t sum=Delta*Loops;
+     for(int Loop=0; Loop<Loops; Loop++)
+     { v1 -= (v0<<4) ^ (v0 + sum) ^ (v0>>5);
+       v0 -= (v1<<4) ^ (v1 + sum) ^ (v1>>5);
+       sum -= Delta; }
+   }
+
+   static OGN_Packet &Get(OGN_Packet   &Packet) { return Packet; }
+   static OGN_Packet &Get(OGN_RxPacket &Packet) { return Packet.Packet; }
+   static OGN_Packet &Get(OGN_TxPacket &Packet) { return Packet.Packet; }
+
+   template <class Packet>
+    static void Process(Packet *Pkt, int Count, bool Dewhiten)
+   { int Idx=0;
+     for( ; Idx+Lanes<=Count; Idx+=Lanes)                  // full groups: gather the packets into the lanes
+     { for(int Block=0; Block<4; Block+=2)                 // the position is two independent TEA blocks
+       { Vect v0, v1;
+         for(int Lane=0; Lane<Lanes; Lane++)
+         { uint32_t *Data = Get(Pkt[Idx+Lane]).Data+Block;
+           Elem(v0, Lane)=Data[0]; Elem(v1, Lane)=Data[1]; }
+         if(Dewhiten) Decrypt(v0, v1); else Encrypt(v0, v1);
+         for(int Lane=0; Lane<Lanes; Lane++)
+         { uint32_t *Data = Get(Pkt[Idx+Lane]).Data+Block;
+           Data[0]=Elem(v0, Lane); Data[1]=Elem(v1, Lane); }
+       }
+     }
+     for( ; Idx<Count; Idx++)                              // the remaining packets one by one
+     { if(Dewhiten) Get(Pkt[Idx]).Dewhiten(); else Get(Pkt[Idx]).Whiten(); }
+   }
+
+  public:
+
+   template <class Packet>                                 // OGN_Packet, OGN_RxPacket or OGN_TxPacket
+    static void Whiten  (Packet *Pkt, int Count) { Process(Pkt, Count, 0); }
+
+   template <class Packet>
+    static void Dewhiten(Packet *Pkt, int Count) { Process(Pkt, Count, 1); }
+
+} ;
+
+#endif // __OGN_BATCH_H__
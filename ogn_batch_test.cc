@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ogn.h"
+#include "ogn_batch.h"
+#include "hosttest.h"
+
+// check the unrolled key-0 TEA of OGN_Packet::Whiten()/Dewhiten() and the SIMD batch whitening bit-for-bit
+// against the run-time loop version TEA_Encrypt_Key0(Data, Loops), and measure the cost per packet
+// compile: g++ -O2 -std=gnu++14 -march=native -Wno-psabi ogn_batch_test.cc format.cpp intmath.cpp ldpc.cpp bitcount.cpp -o ogn_batch_test
+
+static void RefWhiten  (OGN_Packet &Packet)                  // as Whiten()/Dewhiten() were before: run-time loop count
+{ OGN_Packet::TEA_Encrypt_Key0(Packet.Data, 8); OGN_Packet::TEA_Encrypt_Key0(Packet.Data+2, 8); }
+
+static void RefDewhiten(OGN_Packet &Packet)
+{ OGN_Packet::TEA_Decrypt_Key0(Packet.Data, 8); OGN_Packet::TEA_Decrypt_Key0(Packet.Data+2, 8); }
+
+static int Compare(const OGN_Packet *A, const OGN_Packet *B, int Packets) // returns number of packets which differ
+{ int Err=0;
+  for(int Idx=0; Idx<Packets; Idx++)
+    if(memcmp(A[Idx].Byte(), B[Idx].Byte(), OGN_Packet::Bytes)) Err++;
+  return Err; }
+
+int main(int argc, char *argv[])
+{ int Packets = 100003;                                      // not a multiple of the lanes: the remainder is tested as well
+  if(argc>1) Packets=atoi(argv[1]);
+  OGN_Packet *Orig = new OGN_Packet[Packets];
+  OGN_Packet *Ref  = new OGN_Packet[Packets];
+  OGN_Packet *Test = new OGN_Packet[Packets];
+  OGN_RxPacket *RxTest = new OGN_RxPacket[Packets];
+  srandom(12345);
+  for(int Idx=0; Idx<Packets; Idx++)
+  { uint32_t *Word = Orig[Idx].Word();
+    for(int W=0; W<OGN_Packet::Words; W++)
+      Word[W] = ((uint32_t)random()<<16) ^ random(); }
+
+  int Errors=0; uint64_t Start, Time;
+
+  memcpy(Ref, Orig, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); for(int Idx=0; Idx<Packets; Idx++) RefWhiten(Ref[Idx]); Time=Cycles()-Start;
+  printf("Whiten   loop:     %5.1f cycles/packet\n", (double)Time/Packets);
+
+  memcpy(Test, Orig, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); for(int Idx=0; Idx<Packets; Idx++) Test[Idx].Whiten(); Time=Cycles()-Start;
+  int Err=Compare(Ref, Test, Packets); Errors+=Err;
+  printf("Whiten   unrolled: %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  memcpy(Test, Orig, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); OGN_WhitenBatch<8>::Whiten(Test, Packets); Time=Cycles()-Start;
+  Err=Compare(Ref, Test, Packets); Errors+=Err;
+  printf("Whiten   batch 8:  %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  memcpy(Test, Orig, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); OGN_WhitenBatch<16>::Whiten(Test, Packets); Time=Cycles()-Start;
+  Err=Compare(Ref, Test, Packets); Errors+=Err;
+  printf("Whiten   batch 16: %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  for(int Idx=0; Idx<Packets; Idx++) RxTest[Idx].Packet=Orig[Idx];  // received packets: different stride
+  OGN_WhitenBatch<8>::Whiten(RxTest, Packets);
+  Err=0; for(int Idx=0; Idx<Packets; Idx++) if(memcmp(RxTest[Idx].Byte(), Ref[Idx].Byte(), OGN_Packet::Bytes)) Err++;
+  Errors+=Err; printf("Whiten   batch Rx: %d packets differ\n", Err);
+
+  memcpy(Test, Ref, Packets*sizeof(OGN_Packet));               // now de-whiten the whitened ones
+  Start=Cycles(); for(int Idx=0; Idx<Packets; Idx++) RefDewhiten(Test[Idx]); Time=Cycles()-Start;
+  Err=Compare(Orig, Test, Packets); Errors+=Err;
+  printf("Dewhiten loop:     %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  memcpy(Test, Ref, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); for(int Idx=0; Idx<Packets; Idx++) Test[Idx].Dewhiten(); Time=Cycles()-Start;
+  Err=Compare(Orig, Test, Packets); Errors+=Err;
+  printf("Dewhiten unrolled: %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  memcpy(Test, Ref, Packets*sizeof(OGN_Packet));
+  Start=Cycles(); OGN_WhitenBatch<8>::Dewhiten(Test, Packets); Time=Cycles()-Start;
+  Err=Compare(Orig, Test, Packets); Errors+=Err;
+  printf("Dewhiten batch 8:  %5.1f cycles/packet, %d packets differ\n", (double)Time/Packets, Err);
+
+  OGN_WhitenBatch<8>::Dewhiten(RxTest, Packets);
+  Err=0; for(int Idx=0; Idx<Packets; Idx++) if(memcmp(RxTest[Idx].Byte(), Orig[Idx].Byte(), OGN_Packet::Bytes)) Err++;
+  Errors+=Err; printf("Dewhiten batch Rx: %d packets differ\n", Err);
+
+  delete [] Orig; delete [] Ref; delete [] Test; delete [] RxTest;
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
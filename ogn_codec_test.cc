@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ogn.h"
+#include "hosttest.h"
+
+// check the branch-free UR2V/SR2V field codecs of OGN_Packet against the range-comparison versions they replaced,
+// over every input value, and measure the encode/decode cost of the packet fields which use them
+// compile: g++ -O2 -std=gnu++14 ogn_codec_test.cc format.cpp intmath.cpp ldpc.cpp bitcount.cpp -o ogn_codec_test
+
+// ---------------------------------------------------------------------------------------------------------------------------------------
+// the range-comparison codecs as they were in ogn.h
+
+class RefCodec
+{ public:
+   static uint16_t EncodeUR2V8(uint16_t Value)
+   {      if(Value<0x100) { }
+     else if(Value<0x300) Value = 0x100 | ((Value-0x100)>>1);
+     else if(Value<0x700) Value = 0x200 | ((Value-0x300)>>2);
+     else if(Value<0xF00) Value = 0x300 | ((Value-0x700)>>3);
+     else                 Value = 0x3FF;
+     return Value; }
+
+   static uint16_t DecodeUR2V8(uint16_t Value)
+   { uint16_t  Range = Value>>8;
+     Value &= 0x0FF;
+     if(Range==0) return Value;
+     if(Range==1) return 0x101+(Value<<1);
+     if(Range==2) return 0x302+(Value<<2);
+     return 0x704+(Value<<3); }
+
+   static uint8_t EncodeUR2V5(uint16_t Value)
+   {      if(Value<0x020) { }
+     else if(Value<0x060) Value = 0x020 | ((Value-0x020)>>1);
+     else if(Value<0x0E0) Value = 0x040 | ((Value-0x060)>>2);
+     else if(Value<0x1E0) Value = 0x060 | ((Value-0x0E0)>>3);
+     else                 Value = 0x07F;
+     return Value; }
+
+   static uint16_t DecodeUR2V5(uint16_t Value)
+   { uint8_t Range = (Value>>5)&0x03;
+             Value &= 0x1F;
+          if(Range==0) { }
+     else if(Range==1) { Value = 0x021+(Value<<1); }
+     else if(Range==2) { Value = 0x062+(Value<<2); }
+     else              { Value = 0x0E4+(Value<<3); }
+     return Value; }
+
+   static uint8_t EncodeSR2V5(int16_t Value)
+   { uint8_t Sign=0; if(Value<0) { Value=(-Value); Sign=0x80; }
+     Value = EncodeUR2V5(Value);
+     return Value | Sign; }
+
+   static  int16_t DecodeSR2V5( int16_t Value)
+   { int16_t Sign =  Value&0x80;
+     Value = DecodeUR2V5(Value&0x7F);
+     return Sign ? -Value: Value; }
+
+   static uint16_t EncodeUR2V6(uint16_t Value)
+   {      if(Value<0x040) { }
+     else if(Value<0x0C0) Value = 0x040 | ((Value-0x040)>>1);
+     else if(Value<0x1C0) Value = 0x080 | ((Value-0x0C0)>>2);
+     else if(Value<0x3C0) Value = 0x0C0 | ((Value-0x1C0)>>3);
+     else                 Value = 0x0FF;
+     return Value; }
+
+   static uint16_t DecodeUR2V6(uint16_t Value)
+   { uint16_t Range  = (Value>>6)&0x03;
+             Value &= 0x3F;
+          if(Range==0) { }
+     else if(Range==1) { Value = 0x041+(Value<<1); }
+     else if(Range==2) { Value = 0x0C2+(Value<<2); }
+     else              { Value = 0x1C4+(Value<<3); }
+     return Value; }
+
+   static uint16_t EncodeSR2V6(int16_t Value)
+   { uint16_t Sign=0; if(Value<0) { Value=(-Value); Sign=0x100; }
+     Value = EncodeUR2V6(Value);
+     return Value | Sign; }
+
+   static  int16_t DecodeSR2V6( int16_t Value)
+   { int16_t Sign =  Value&0x100;
+     Value = DecodeUR2V6(Value&0x00FF);
+     return Sign ? -Value: Value; }
+
+   static uint16_t EncodeUR2V12(uint16_t Value)
+   {      if(Value<0x1000) { }
+     else if(Value<0x3000) Value = 0x1000 | ((Value-0x1000)>>1);
+     else if(Value<0x7000) Value = 0x2000 | ((Value-0x3000)>>2);
+     else if(Value<0xF000) Value = 0x3000 | ((Value-0x7000)>>3);
+     else                  Value = 0x3FFF;
+     return Value; }
+
+   static uint16_t DecodeUR2V12(uint16_t Value)
+   { uint16_t Range = Value>>12;
+              Value &=0x0FFF;
+     if(Range==0) return         Value;
+     if(Range==1) return 0x1001+(Value<<1);
+     if(Range==2) return 0x3002+(Value<<2);
+     return 0x7004+(Value<<3); }
+
+   static uint8_t EncodeDOP(uint8_t DOP)
+   {      if(DOP<0x10) { }
+     else if(DOP<0x30) DOP = 0x10 | ((DOP-0x10)>>1);
+     else if(DOP<0x70) DOP = 0x20 | ((DOP-0x30)>>2);
+     else if(DOP<0xF0) DOP = 0x30 | ((DOP-0x70)>>3);
+     else              DOP = 0x3F;
+     return DOP; }
+
+   static uint8_t DecodeDOP(uint8_t DOP)
+   { uint8_t Range = DOP>>4;
+     DOP &= 0x0F;
+     if(Range==0) return       DOP;
+     if(Range==1) return 0x11+(DOP<<1);
+     if(Range==2) return 0x32+(DOP<<2);
+     return 0x74+(DOP<<3); }
+
+} ;
+
+// ---------------------------------------------------------------------------------------------------------------------------------------
+
+static int Errors=0;
+
+static void Report(const char *Name, int Err, int Count)
+{ printf("%-14s %6d values, %d differ\n", Name, Count, Err); Errors+=Err; }
+
+#define TEST_UNSIGNED(Func, Range) \
+{ int Err=0; for(int Value=0; Value<(Range); Value++) if(OGN_Packet::Func(Value)!=RefCodec::Func(Value)) Err++; Report(#Func, Err, Range); }
+
+#define TEST_SIGNED(Func) \
+{ int Err=0; for(int Value=-32768; Value<32768; Value++) if(OGN_Packet::Func(Value)!=RefCodec::Func(Value)) Err++; Report(#Func, Err, 65536); }
+
+static void TestDOP(void)
+{ OGN_Packet Packet; int EncErr=0, DecErr=0;
+  for(int DOP=0; DOP<256; DOP++)
+  { Packet.EncodeDOP(DOP); if(Packet.Position.DOP!=RefCodec::EncodeDOP(DOP)) EncErr++; }
+  for(int DOP=0; DOP<64; DOP++)
+  { Packet.Position.DOP=DOP; if(Packet.DecodeDOP()!=RefCodec::DecodeDOP(DOP)) DecErr++; }
+  Report("EncodeDOP", EncErr, 256);
+  Report("DecodeDOP", DecErr, 64); }
+
+// ---------------------------------------------------------------------------------------------------------------------------------------
+// cost per packet: the fields which go through these codecs when a position packet is encoded and decoded
+
+class Fields
+{ public:
+  uint16_t Altitude, Speed, DOP; int16_t Climb, Turn; } ;
+
+template <class Codec>
+ static double EncodeCost(const Fields *Input, int Packets)   // [cycles/packet]
+{ uint32_t Sum=0;
+  uint64_t Start=Cycles();
+  for(int Pkt=0; Pkt<Packets; Pkt++)
+  { const Fields &Inp = Input[Pkt];
+    Sum += Codec::EncodeUR2V12(Inp.Altitude) + Codec::EncodeUR2V8(Inp.Speed) + Codec::EncodeSR2V6(Inp.Climb)
+         + Codec::EncodeSR2V5(Inp.Turn) + Codec::EncodeUR2V5(Inp.DOP); }
+  uint64_t Time=Cycles()-Start;
+  if(Sum==0x12345678) printf("\n");                            // keep the compiler from removing the loop
+  return (double)Time/Packets; }
+
+template <class Codec>
+ static double DecodeCost(const Fields *Input, int Packets)   // [cycles/packet]
+{ uint32_t Sum=0;
+  uint64_t Start=Cycles();
+  for(int Pkt=0; Pkt<Packets; Pkt++)
+  { const Fields &Inp = Input[Pkt];
+    Sum += Codec::DecodeUR2V12(Inp.Altitude&0x3FFF) + Codec::DecodeUR2V8(Inp.Speed&0x3FF) + Codec::DecodeSR2V6(Inp.Climb&0x1FF)
+         + Codec::DecodeSR2V5(Inp.Turn&0xFF) + Codec::DecodeUR2V5(Inp.DOP&0x7F); }
+  uint64_t Time=Cycles()-Start;
+  if(Sum==0x12345678) printf("\n");
+  return (double)Time/Packets; }
+
+int main(int argc, char *argv[])
+{ TEST_UNSIGNED(EncodeUR2V8,  0x10000);
+  TEST_UNSIGNED(DecodeUR2V8,  0x400);
+  TEST_UNSIGNED(EncodeUR2V5,  0x10000);
+  TEST_UNSIGNED(DecodeUR2V5,  0x10000);
+  TEST_UNSIGNED(EncodeUR2V6,  0x10000);
+  TEST_UNSIGNED(DecodeUR2V6,  0x10000);
+  TEST_UNSIGNED(EncodeUR2V12, 0x10000);
+  TEST_UNSIGNED(DecodeUR2V12, 0x4000);
+  TEST_SIGNED(EncodeSR2V5);
+  TEST_SIGNED(DecodeSR2V5);
+  TEST_SIGNED(EncodeSR2V6);
+  TEST_SIGNED(DecodeSR2V6);
+  TestDOP();
+
+  int Packets = 1000000;
+  if(argc>1) Packets=atoi(argv[1]);
+  Fields *Input = new Fields[Packets];
+  srandom(12345);
+  for(int Pkt=0; Pkt<Packets; Pkt++)                           // values spread over all ranges, as for real traffic
+  { Fields &Inp = Input[Pkt];
+    Inp.Altitude = random()%6000; Inp.Speed = random()%800; Inp.DOP = random()%100;
+    Inp.Climb = random()%400-200; Inp.Turn = random()%600-300; }
+  printf("Encode: %5.1f cycles/packet before, %5.1f now\n", EncodeCost<RefCodec>(Input, Packets), EncodeCost<OGN_Packet>(Input, Packets));
+  printf("Decode: %5.1f cycles/packet before, %5.1f now\n", DecodeCost<RefCodec>(Input, Packets), DecodeCost<OGN_Packet>(Input, Packets));
+  delete [] Input;
+
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "ogn.h"
+#include "ldpc.h"
+#include "hosttest.h"
+
+// sensitivity and decode time of the long-range PPM mode (OGN_PPM_Decoder, n354k160 code, 64-ary PPM)
+// against the FSK mode (n208k160 code, Manchester coded FSK, bit-flipping + 8-bit layered decoder like the tracker)
+// both at the same energy per user bit: Eb/N0 is given per the 160 user bits of the packet.
+// compile: g++ -O2 -std=gnu++14 -DWITH_PPM ppm_test.cc ldpc.cpp bitcount.cpp format.cpp intmath.cpp -o ppm_test
+// usage:   ppm_test [packets] [from_dB] [to_dB]
+//
+// PPM: every slot has 64 pulse positions, the receiver measures the energy of every position (non-coherent),
+//      the demodulator gives the log-likelihood ln(I0(2*A*|r|/N0)) of every position to the decoder.
+// FSK: every chip is a non-coherent FSK hard decision with chip error rate 0.5*exp(-Ec/2N0),
+//      equal Manchester chips are reported as erased, like the RF chip does in the tracker.
+
+static double LogI0(double X)                                   // ln(I0(x)) Abramowitz-Stegun 9.8.1 and 9.8.2
+{ if(X<3.75)
+  { double T=X/3.75; T*=T;
+    return log(1.0+T*(3.5156229+T*(3.0899424+T*(1.2067492+T*(0.2659732+T*(0.0360768+T*0.0045813)))))); }
+  double T=3.75/X;
+  return X - 0.5*log(X) + log(0.39894228+T*(0.01328592+T*(0.00225319+T*(-0.00157565+T*(0.00916281
+                                 +T*(-0.02057706+T*(0.02635537+T*(-0.01647633+T*0.00392377)))))))); }
+
+static void RandomPacket(OGN_Packet &Packet)
+{ Packet.Clear();
+  Packet.Header.Address  = random()&0x00FFFFFF;
+  Packet.Header.AddrType = random()&3;
+  Packet.calcAddrParity();
+  Packet.Position.FixQuality = 1;
+  Packet.Position.FixMode    = 1;
+  Packet.Position.Time       = random()%60;
+  Packet.EncodeLatitude ((int32_t)(random()%(180*600000))-90*600000);
+  Packet.EncodeLongitude((int32_t)(random()%(360*600000))-180*600000);
+  Packet.EncodeAltitude(random()%5000);
+  Packet.Whiten(); }
+
+static OGN_PPM_Decoder<float>           FloatDecoder;
+static OGN_PPM_Decoder<int16_t, int8_t> FixedDecoder;
+static LDPC_LayeredDecoder<int8_t>      FSK_Decoder;
+
+static const double MetricScale = 4.0;                          // fixed-point: int8 log-likelihood in units of 1/4
+                                                                // a constant per slot does not matter, thus it is taken relative to the strongest pulse
+
+int main(int argc, char *argv[])
+{ int Packets = 2000;
+  double EbN0_From=2.0, EbN0_To=10.0;
+  if(argc>1) Packets=atoi(argv[1]);
+  if(argc>2) EbN0_From=atof(argv[2]);
+  if(argc>3) EbN0_To=atof(argv[3]);
+  srandom(12345);
+
+  const int Symbols = OGN_PPM_Decoder<float>::CodeSymbols;
+  const int Pulses  = OGN_PPM_Decoder<float>::PulsesPerSlot;
+  static float Energy[59][64];                                  // [A^2] received energy of every pulse position
+
+  printf("# %d packets per point, Eb/N0 per user bit\n", Packets);
+  printf("# Eb/N0   FSK: FER    PPM float: FER  Loops  [us]   PPM int16: FER  Loops  [us]\n");
+  for(double EbN0=EbN0_From; EbN0<=EbN0_To+0.001; EbN0+=1.0)
+  { double Eb = pow(10.0, 0.1*EbN0);                            // [N0]
+    double Es = Eb*160/Symbols;                                 // [N0] energy per PPM symbol (one pulse)
+    double A  = sqrt(Es);
+    double Ec = Eb*160/(2*208);                                 // [N0] energy per FSK chip
+    double ChipErr = 0.5*exp(-Ec/2);
+    int FSK_Err=0, FloatErr=0, FixedErr=0; long FloatLoops=0, FixedLoops=0;
+    double FloatTime=0, FixedTime=0;
+    for(int Pkt=0; Pkt<Packets; Pkt++)
+    { OGN_PPM_Packet TxPacket;
+      TxPacket.clear();
+      RandomPacket(TxPacket.Packet);
+      TxPacket.calcFEC();
+
+      for(int Symb=0; Symb<Symbols; Symb++)                     // PPM channel: energy detector on every pulse position
+      { int TxPulse=TxPacket.getSymbol(Symb);
+        for(int Pulse=0; Pulse<Pulses; Pulse++)
+        { double I = GaussNoise()*sqrt(0.5), Q = GaussNoise()*sqrt(0.5);
+          if(Pulse==TxPulse) I+=A;
+          Energy[Symb][Pulse] = I*I+Q*Q; }
+      }
+      FloatDecoder.Clear(); FixedDecoder.Clear();
+      for(int Symb=0; Symb<Symbols; Symb++)
+      { double LogLike[64]; double Max=0;
+        for(int Pulse=0; Pulse<Pulses; Pulse++)
+        { LogLike[Pulse] = LogI0(2*A*sqrt(Energy[Symb][Pulse]));
+          if(LogLike[Pulse]>Max) Max=LogLike[Pulse]; }
+        for(int Pulse=0; Pulse<Pulses; Pulse++)
+        { FloatDecoder.addSymbol(Symb, Pulse, LogLike[Pulse]);
+          int Fixed = floor(MetricScale*(LogLike[Pulse]-Max)+0.5); if(Fixed<(-127)) Fixed=(-127); // relative to the strongest pulse of the slot
+          FixedDecoder.addSymbol(Symb, Pulse, Fixed); }
+      }
+      uint32_t Decoded[12]; uint8_t Loops;
+      clock_t Start=clock();
+      int Check=FloatDecoder.Process(24, &Loops);
+      FloatTime+=clock()-Start; FloatLoops+=Loops;
+      FloatDecoder.Output(Decoded);
+      if( Check || memcmp(Decoded, TxPacket.Packet.Word(), 20) ) FloatErr++;
+      Start=clock();
+      Check=FixedDecoder.Process(24, &Loops);
+      FixedTime+=clock()-Start; FixedLoops+=Loops;
+      FixedDecoder.Output(Decoded);
+      if( Check || memcmp(Decoded, TxPacket.Packet.Word(), 20) ) FixedErr++;
+
+      uint32_t Codeword[7];                                     // FSK channel: the same packet with the n208k160 code
+      Codeword[6]=0;
+      memcpy(Codeword, TxPacket.Packet.Word(), 20);
+      LDPC_Encode(Codeword);
+      uint8_t Data[26], Err[26];
+      memset(Data, 0, 26); memset(Err, 0, 26);
+      for(int Bit=0; Bit<208; Bit++)
+      { bool One   = (Codeword[Bit>>5]>>(Bit&31))&1;
+        bool Chip0 = One  ^ (UniformNoise()<ChipErr);
+        bool Chip1 = (!One) ^ (UniformNoise()<ChipErr);
+        if(Chip0) Data[Bit>>3] |= 1<<(Bit&7);
+        if(Chip0==Chip1) Err[Bit>>3] |= 1<<(Bit&7); }
+      uint32_t Word[7], Erased[7];
+      Word[6]=0; Erased[6]=0;
+      memcpy(Word, Data, 26); memcpy(Erased, Err, 26);
+      Check=LDPC_FlipBits(Word, Erased);
+      if(Check)
+      { FSK_Decoder.Input(Data, Err);
+        for(int Iter=0; Iter<16; Iter++)
+        { Check=FSK_Decoder.ProcessChecks(); if(Check==0) break; }
+        FSK_Decoder.Output(Word); }
+      if( Check || memcmp(Word, Codeword, 20) ) FSK_Err++;
+    }
+    printf("%5.1f   %10.4f   %14.4f %6.2f %5.0f   %14.4f %6.2f %5.0f\n", EbN0,
+           (double)FSK_Err/Packets,
+           (double)FloatErr/Packets, (double)FloatLoops/Packets, 1e6*FloatTime/CLOCKS_PER_SEC/Packets,
+           (double)FixedErr/Packets, (double)FixedLoops/Packets, 1e6*FixedTime/CLOCKS_PER_SEC/Packets);
+    fflush(stdout); }
+
+  return 0; }
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ogn.h"
+
+// relay queue: the indexed OGN_IndexPrioQueue against the linear OGN_PrioQueue at 16, 64 and 256 slots
+// (OGN_PrioQueue counts the slots with uint8_t thus it stops at 255)
+// every second: some positions are received, some are picked for relay and the 20-second old ones are removed,
+// like proc.cpp does. The indexed queue is also checked against a plain scan of the slots after every second.
+// compile: g++ -O2 -std=gnu++14 prioqueue_test.cc format.cpp intmath.cpp ldpc.cpp bitcount.cpp -o prioqueue_test
+
+static const int Seconds = 2000;
+
+static uint32_t Rand=1;
+
+static uint32_t Random(void)                                        // XorShift32, like the tracker
+{ Rand^=Rand<<13; Rand^=Rand>>17; Rand^=Rand<<5; return Rand; }
+
+template <class Queue>
+ static void Receive(Queue &RelayQueue, uint32_t Address, uint8_t Time)
+{ auto Idx=RelayQueue.getNew();
+  OGN_RxPacket *Packet=RelayQueue[Idx];
+  Packet->Packet.HeaderWord=Address;
+  Packet->Rank=1+Random()%255;
+  RelayQueue.addNew(Idx, Time); }
+
+template <class Queue>
+ static double Run(Queue &RelayQueue, int Aircrafts, int PerSec, int Relays, int (*Check)(Queue &, uint8_t)=0, int *Errors=0)
+{ RelayQueue.Clear(); Rand=1;
+  clock_t Start=clock();
+  for(int Sec=0; Sec<Seconds; Sec++)
+  { uint8_t Time=Sec%60;
+    for(int Pkt=0; Pkt<PerSec; Pkt++)
+      Receive(RelayQueue, Random()%Aircrafts, Time);
+    for(int Relay=0; Relay<Relays; Relay++)
+    { uint32_t Pick=Random();
+      if(RelayQueue.Packet[RelayQueue.getRand(Pick)].Rank==0) continue;
+      RelayQueue.decrRank(RelayQueue.getRand(Pick)); }
+    RelayQueue.cleanTime((Sec+60-20)%60);
+    if(Check) *Errors+=Check(RelayQueue, (Sec+60-20)%60); }
+  return 1e6*(clock()-Start)/CLOCKS_PER_SEC/Seconds; }           // [us] per second of traffic
+
+template <uint16_t Size>
+ static int CheckIndex(OGN_IndexPrioQueue<Size> &RelayQueue, uint8_t OldTime) // compare the tree against a plain scan
+{ int Errors=0; uint16_t Sum=0; uint8_t Low=0xFF;
+  for(int Idx=0; Idx<Size; Idx++)
+  { uint8_t Rank=RelayQueue.Packet[Idx].Rank;
+    Sum+=Rank; if(Rank<Low) Low=Rank;
+    if(Rank==0) continue;
+    if(RelayQueue.Time[Idx]==OldTime) Errors++;                   // should have been removed
+    for(int Other=Idx+1; Other<Size; Other++)                       // no two packets of the same aircraft
+      if( RelayQueue.Packet[Other].Rank && (RelayQueue.Packet[Other].Packet.HeaderWord==RelayQueue.Packet[Idx].Packet.HeaderWord) ) Errors++; }
+  if(Sum!=RelayQueue.getSum()) Errors++;
+  if(RelayQueue.Packet[RelayQueue.getLow()].Rank!=Low) Errors++;
+  for(int Test=0; Test<16; Test++)                                  // weighted pick same as the linear walk
+  { uint32_t Pick=random();
+    int Idx; uint16_t RankIdx=Sum ? Pick%Sum:0, RankSum=0;
+    for(Idx=0; Idx<Size; Idx++)
+    { RankSum+=RelayQueue.Packet[Idx].Rank; if(RankSum>RankIdx) break; }
+    if( Sum && (RelayQueue.getRand(Pick)!=Idx) ) Errors++; }
+  return Errors; }
+
+template <uint8_t LinSize, uint16_t IdxSize>
+ static int Compare(int Aircrafts, int PerSec, int Relays)
+{ static OGN_PrioQueue<LinSize>      Linear;
+  static OGN_IndexPrioQueue<IdxSize> Indexed;
+  int Errors=0;
+  double LinTime = Run(Linear,  Aircrafts, PerSec, Relays);
+  double IdxTime = Run(Indexed, Aircrafts, PerSec, Relays);
+  Run(Indexed, Aircrafts, PerSec, Relays, CheckIndex<IdxSize>, &Errors);
+  printf("%3d/%3d slots %4d aircrafts %3d pkt/s: linear %7.2f us/s  indexed %7.2f us/s  %d errors\n",
+         LinSize, IdxSize, Aircrafts, PerSec, LinTime, IdxTime, Errors);
+  return Errors; }
+
+int main(int argc, char *argv[])
+{ int Errors=0;
+  Errors+=Compare< 16,  16>(  40,  20,  4);
+  Errors+=Compare< 64,  64>( 160,  80,  4);
+  Errors+=Compare<255, 256>( 600, 300,  4);
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
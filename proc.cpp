@@ -7,15 +7,60 @@
 #include "ogn.h"
 
 #include "rf.h"
+#include "fec.h"
+#include "traffic.h"
+#include "lookout.h"
+#include "txrate.h"
+#include "rxcheck.h"
 #include "gps.h"
 
 #ifdef WITH_FLASHLOG
 #include "flashlog.h"
 #endif
 
-static char           Line[128];      // for printing out to serial port, etc.
-
-static LDPC_Decoder     Decoder;      // error corrector for the OGN Gallager code
+static char           Line[160];      // for printing out to serial port, etc.: $POGNR can take up to 142 characters when all the counters are at their maximum
+
+class FEC_Counters                            // how hard the FEC works: counted per second, reported in $POGNR
+{ public:
+   static const uint8_t HistBins = 6;
+   uint16_t Attempted;                        // received frames given to the decoder
+   uint16_t Clean;                            // passed the parity checks without any correction or erasure
+   uint16_t Corrected;                        // recovered by the FEC
+   uint16_t CorrBits;                         // sum of RxErr (erased+corrected bits) of the recovered frames
+   uint16_t Rejected;                         // failed the FEC or too many bit errors
+   uint16_t Dropped;                          // not corrected as the FEC queue was full
+   uint16_t Suspect;                          // passed the FEC but failed the acceptance tests: likely a false decode
+   uint16_t IterHist[HistBins];               // recovered frames vs. soft-decoder iterations: 0 (bit-flipping), 1, 2-3, 4-7, 8-15, 16+
+
+  public:
+   void Clear(void)
+   { Attempted=0; Clean=0; Corrected=0; CorrBits=0; Rejected=0; Dropped=0; Suspect=0;
+     for(uint8_t Bin=0; Bin<HistBins; Bin++) IterHist[Bin]=0; }
+
+   void addCorrected(uint8_t RxErr, uint8_t Iter)
+   { Corrected++; CorrBits+=RxErr;
+     uint8_t Bin=0; while(Iter) { Bin++; Iter>>=1; }
+     if(Bin>=HistBins) Bin=HistBins-1;
+     IterHist[Bin]++; }
+
+   uint8_t Format(char *Out) const            // comma-separated, histogram bins separated by slashes
+   { uint8_t Len=0;
+     Len+=Format_UnsDec(Out+Len, Attempted); Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, Clean);     Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, Corrected); Out[Len++]=',';
+     for(uint8_t Bin=0; Bin<HistBins; Bin++)
+     { if(Bin) Out[Len++]='/';
+       Len+=Format_UnsDec(Out+Len, IterHist[Bin]); }
+     Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, CorrBits);  Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, Rejected);  Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, Dropped);   Out[Len++]=',';
+     Len+=Format_UnsDec(Out+Len, Suspect);
+     return Len; }
+
+} ;
+
+static FEC_Counters FEC_Stat;                 // reset every time they are reported
 
 // #define DEBUG_PRINT
 
@@ -23,7 +68,71 @@ static LDPC_Decoder     Decoder;      // error corrector for the OGN Gallager co
 
 // ---------------------------------------------------------------------------------------------------------------------------------------
 
-static OGN_PrioQueue<16> RelayQueue;  // received packets and candidates to be relayed
+static OGN_IndexPrioQueue<32> RelayQueue; // received packets and candidates to be relayed
+static uint16_t               RelayOverheard=0; // relays by other trackers of the aircrafts we hold: reported and reset with $POGNR
+static OGN_TxRate             TxRate;     // relay and stationary position rates by the channel load
+static OGN_TrafficTable<16>   Traffic;    // aircrafts around: last position of every one
+                                          // 16 targets (52 bytes each) is what the RAM allows: when more are around the one not heard
+                                          // for the longest time is replaced, thus it is not predicted; lookout_test checks the CPU cost for 50
+#ifdef WITH_PFLAA
+const uint8_t TrafficPredictTime = 8;     // [sec] how long to extrapolate targets not heard
+
+static uint8_t WritePOGNP(char *NMEA, uint32_t AddressAndType, uint8_t Age) // follows the $PFLAA of an extrapolated target
+{ uint8_t Len=0;                                               // $PFLAA has no field for it: FLARM parsers see a normal target
+  Len+=Format_String(NMEA+Len, "$POGNP,");
+  NMEA[Len++]='0'+((AddressAndType>>24)&3);                    // address-type
+  NMEA[Len++]=',';
+  Len+=Format_Hex(NMEA+Len, AddressAndType&0x00FFFFFF, 6);     // address
+  NMEA[Len++]=',';
+  Len+=Format_UnsDec(NMEA+Len, (uint16_t)Age);                 // [sec] since the last received position
+  Len+=NMEA_AppendCheckCRNL(NMEA, Len);
+  NMEA[Len]=0;
+  return Len; }
+
+static void PredictTraffic(uint32_t SlotTime)                  // once per slot: $PFLAA with the extrapolated position of targets
+{ uint8_t Sec = (SlotTime+59)%60;                              // positions received during the slot just over carry that time
+  for(uint8_t Idx=0; Idx<Traffic.Size; Idx++)                  // thus targets missed in that slot are predicted to it
+  { OGN_TrafficTarget *Target=Traffic[Idx];
+    if(Target->isFree() || (Target->Time>=60)) continue;
+    uint8_t Age = (Sec+60-Target->Time)%60;                    // [sec] since the last received position
+    if( (Age==0) || (Age>TrafficPredictTime) ) continue;       // position received in this slot or too old
+    OGN_PacketView View = Target->View;
+    if(OGN_PacketView::calcDistanceVector(View.LatDist, View.LonDist, View.Latitude, View.Longitude, GPS_Latitude, GPS_Longitude, GPS_LatCosine)<0) continue;
+    LookOut_Motion Motion;                                     // along the circle given by the last speed, heading, climb and turn rate
+    Motion.Set(View.LatDist, View.LonDist, View.Altitude, View.Speed, View.Heading, View.ClimbRate, View.TurnRate);
+    for(uint8_t Step=0; Step<Age; Step++) Motion.Step();
+    View.LatDist  = Motion.N>>4; View.LonDist = Motion.E>>4; View.Altitude = Motion.U>>4;
+    if(Motion.Turn)
+    { int16_t Dir = IntAtan2(Motion.VE, Motion.VN);           // the heading has changed in the turn
+      View.Heading = ((uint32_t)(uint16_t)Dir*3600+0x8000)>>16; }
+    xSemaphoreTake(CONS_Mutex, portMAX_DELAY);                 // both sentences together: nothing may come between them
+    uint8_t Len=OGN_Packet::WritePFLAA(Line, Target->Alarm, View, View.Altitude-GPS_Altitude/10,
+                                       Target->AddressAndType>>24, Target->AddressAndType, Target->AcftType);
+    Format_String(CONS_UART_Write, Line, 0, Len);
+    Len=WritePOGNP(Line, Target->AddressAndType, Age);
+    Format_String(CONS_UART_Write, Line, 0, Len);
+    xSemaphoreGive(CONS_Mutex); }
+}
+#endif
+
+#ifdef WITH_LOOKOUT
+static LookOut                Look;       // collision prediction: own position and motion of the current slot
+static LookOut_Alarm          LookAlarm;  // the most urgent alarm for $PFLAU
+static uint32_t               LookAlarmID;
+
+static void LookOutTraffic(void)                               // predict all targets, once per slot
+{ LookAlarm.Clear(); LookAlarmID=0;
+  Look.clearStat();
+  for(uint8_t Idx=0; Idx<Traffic.Size; Idx++)
+  { OGN_TrafficTarget *Target=Traffic[Idx];
+    if(Target->isFree()) continue;
+    LookOut_Alarm Alarm;
+    Target->Alarm=Look.Check(Alarm, Target->View, Target->Time);
+    if( (Alarm.Level>LookAlarm.Level) || ( Alarm.Level && (Alarm.Level==LookAlarm.Level) && (Alarm.Time<LookAlarm.Time) ) )
+    { LookAlarm=Alarm; LookAlarmID=Target->AddressAndType; }
+  }
+}
+#endif
 
 #ifdef DEBUG_PRINT
 static void PrintRelayQueue(uint8_t Idx)                    // for debug
@@ -38,13 +147,12 @@ static void PrintRelayQueue(uint8_t Idx)                    // for debug
 #endif
 
 static bool GetRelayPacket(OGN_TxPacket *Packet)      // prepare a packet to be relayed
-{ if(RelayQueue.Sum==0) return 0;                     // if no packets in the relay queue
+{ if(RelayQueue.getSum()==0) return 0;                // if no packets in the relay queue
   XorShift32(RX_Random);                              // produce a new random number
   uint8_t Idx=RelayQueue.getRand(RX_Random);          // get weight-random packet from the relay queue
   if(RelayQueue.Packet[Idx].Rank==0) return 0;        // should not happen ...
-  memcpy(Packet->Packet.Byte(), RelayQueue[Idx]->Byte(), OGN_Packet::Bytes); // copy the packet
-  Packet->Packet.Header.RelayCount+=1;                // increment the relay count (in fact we only do single relay)
-  Packet->Packet.Whiten(); Packet->calcFEC();         // whiten and calc. the FEC code => packet ready for transmission
+  memcpy(Packet->Byte(), RelayQueue[Idx]->Byte(), OGN_TxPacket::Bytes); // copy the packet: already whitened, with the FEC
+  Packet->incrRelayCount();                           // increment the relay count (in fact we only do single relay) and patch the FEC
   // PrintRelayQueue(Idx);  // for debug
   RelayQueue.decrRank(Idx);                           // reduce the rank of the packet selected for relay
   return 1; }
@@ -90,6 +198,14 @@ static void ReadStatus(OGN_TxPacket &StatPacket)                            // r
     Line[Len++]=',';
     Len+=Format_UnsDec(Line+Len, (MCU_VCC+5)/10, 3, 2);
 #endif
+    Line[Len++]=',';
+    Len+=FEC_Stat.Format(Line+Len);                                          // FEC: attempted,clean,corrected,iter.histogram,corr.bits,rejected,dropped,suspect
+    FEC_Stat.Clear();
+    Line[Len++]=',';
+    Len+=Format_UnsDec(Line+Len, RelayOverheard);                            // relays left to other trackers
+    RelayOverheard=0;
+    Line[Len++]=',';
+    Len+=Format_UnsDec(Line+Len, TxRate.Level);                              // channel load level: sets the relay and stationary position rates
 
     Len+=NMEA_AppendCheckCRNL(Line, Len);                                    // append NMEA check-sum and CR+NL
     // LogLine(Line);
@@ -98,7 +214,7 @@ static void ReadStatus(OGN_TxPacket &StatPacket)                            // r
       Format_String(CONS_UART_Write, Line, 0, Len);                               // send the NMEA out to the console
       xSemaphoreGive(CONS_Mutex); }
 #ifdef WITH_SDLOG
-    if(Log_Free()>=128)
+    if(Log_Free()>=Len)
     { xSemaphoreTake(Log_Mutex, portMAX_DELAY);
       Format_String(Log_Write, Line, Len, 0);                                     // send the NMEA out to the log file
       xSemaphoreGive(Log_Mutex); }
@@ -108,10 +224,10 @@ static void ReadStatus(OGN_TxPacket &StatPacket)                            // r
 
 // ---------------------------------------------------------------------------------------------------------------------------------------
 
-static uint8_t WritePFLAU(char *NMEA, uint8_t GPS=1)    // produce the (mostly dummy) PFLAU to satisfy XCsoar and LK8000
-{ uint8_t Len=0;
+static uint8_t WritePFLAU(char *NMEA, uint8_t GPS=1, uint8_t RxCount=0, const LookOut_Alarm *Alarm=0, uint32_t AddressAndType=0) // produce the PFLAU for XCsoar and LK8000
+{ uint8_t Len=0;                                        // with the most urgent alarm from the lookout, if there is one
   Len+=Format_String(NMEA+Len, "$PFLAU,");
-  NMEA[Len++]='0';
+  Len+=Format_UnsDec(NMEA+Len, (uint16_t)(RxCount>99 ? 99:RxCount)); // number of aircrafts received
   NMEA[Len++]=',';
   NMEA[Len++]='0'+GPS;                                  // TX status
   NMEA[Len++]=',';
@@ -119,29 +235,63 @@ static uint8_t WritePFLAU(char *NMEA, uint8_t GPS=1)    // produce the (mostly d
   NMEA[Len++]=',';
   NMEA[Len++]='1';                                      // power status: one could monitor the supply
   NMEA[Len++]=',';
-  NMEA[Len++]='0';
-  NMEA[Len++]=',';
-  NMEA[Len++]=',';
-  NMEA[Len++]='0';
-  NMEA[Len++]=',';
-  NMEA[Len++]=',';
+  if(Alarm && Alarm->Level)
+  { NMEA[Len++]='0'+Alarm->Level;                       // alarm level
+    NMEA[Len++]=',';
+    Len+=Format_SignDec(NMEA+Len, (int32_t)Alarm->Bearing); // [deg] relative bearing
+    NMEA[Len++]=',';
+    NMEA[Len++]='2';                                    // alarm type: aircraft
+    NMEA[Len++]=',';
+    Len+=Format_SignDec(NMEA+Len, (int32_t)Alarm->RelAlt);  // [m] relative vertical
+    NMEA[Len++]=',';
+    Len+=Format_UnsDec(NMEA+Len, (uint32_t)Alarm->Dist);    // [m] relative distance
+    NMEA[Len++]=',';
+    Len+=Format_Hex(NMEA+Len, AddressAndType&0x00FFFFFF, 6); } // ID of the target
+  else
+  { NMEA[Len++]='0';
+    NMEA[Len++]=',';
+    NMEA[Len++]=',';
+    NMEA[Len++]='0';
+    NMEA[Len++]=',';
+    NMEA[Len++]=','; }
   Len+=NMEA_AppendCheckCRNL(NMEA, Len);
   NMEA[Len]=0;
   return Len; }
 
 // ---------------------------------------------------------------------------------------------------------------------------------------
 
-static void ProcessRxPacket(OGN_RxPacket *RxPacket, uint8_t RxPacketIdx)              // process every (correctly) received packet
-{ int32_t LatDist=0, LonDist=0; uint8_t Warn=0;
+static OGN_PacketView RxView;                                                          // decoded fields of the packet being processed
+static OGN_RxPacket   RxPacket;                                                        // dewhitened copy of the packet being processed
+
+static void DecodeRxView(OGN_RxPacket *RxPacket)                                      // decode the (dewhitened) packet once for all the outputs
+{ RxPacket->Packet.Decode(RxView);
+  RxView.calcDistance(GPS_Latitude, GPS_Longitude, GPS_LatCosine); }
+
+static void ProcessRxPacket(OGN_RxPacket *RxPacket, const uint8_t *Image, uint32_t RxTime) // process every (correctly) received packet, RxView already decoded
+{ uint8_t Warn=0;                                                                     // Image = the packet as received: whitened, with valid FEC
   if( RxPacket->Packet.Header.Other || RxPacket->Packet.Header.Encrypted ) return ;   // status packet or encrypted: ignore
   uint8_t MyOwnPacket = ( RxPacket->Packet.Header.Address  == Parameters.Address  )
                      && ( RxPacket->Packet.Header.AddrType == Parameters.AddrType );
   if(MyOwnPacket) return;                                                             // don't process my own (relayed) packets
-  bool DistOK = RxPacket->Packet.calcDistanceVector(LatDist, LonDist, GPS_Latitude, GPS_Longitude, GPS_LatCosine)>=0;
-  if(DistOK)
-  { RxPacket->calcRelayRank(GPS_Altitude/10);                                         // calculate the relay-rank (priority for relay)
-    RelayQueue.addNew(RxPacketIdx);
-    uint8_t Len=RxPacket->WritePOGNT(Line);                                           // print on the console as $POGNT
+  if(RxView.DistOK>=0)
+  { RxPacket->calcRelayRank(GPS_Altitude/10, RxView);                                 // calculate the relay-rank (priority for relay)
+    if( RxPacket->Packet.Header.RelayCount                                            // relayed by another tracker
+     && RelayQueue.overheardRelay(RxPacket->Packet.getAddressAndType()) ) RelayOverheard++; // and we hold that aircraft: no queue slot for the copy
+    else
+    { uint8_t RxPacketIdx = RelayQueue.getNew();                                      // get place for this new packet
+      OGN_RxPacket *Relay = RelayQueue[RxPacketIdx];
+     *Relay = *RxPacket;                                                              // rank and reception info
+      memcpy(Relay->Byte(), Image, OGN_RxPacket::Bytes);                              // but keep the packet ready for transmission
+      uint8_t Time=RxPacket->Packet.Position.Time;
+      if(Time>=60) Time=RxTime%60;                                                    // time not known: expire by the reception time
+      RelayQueue.addNew(RxPacketIdx, Time); }
+    bool IsNew; OGN_TrafficTarget *Target=Traffic[Traffic.Update(*RxPacket, RxView, RxTime, IsNew)];
+    if(!IsNew) return;                                                                // same position already received (other slot or relayed): print only once
+#ifdef WITH_LOOKOUT
+    LookOut_Alarm Alarm;
+    Warn=Target->Alarm=Look.Check(Alarm, RxView, RxPacket->Packet.Position.Time);    // alarm level for $PFLAA
+#endif
+    uint8_t Len=RxPacket->WritePOGNT(Line, RxView);                                   // print on the console as $POGNT
     xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
     Format_String(CONS_UART_Write, Line, 0, Len);
     xSemaphoreGive(CONS_Mutex);
@@ -155,14 +305,14 @@ static void ProcessRxPacket(OGN_RxPacket *RxPacket, uint8_t RxPacketIdx)
       xSemaphoreGive(Log_Mutex); }
 #endif
 #ifdef WITH_PFLAA
-    Len=RxPacket->Packet.WritePFLAA(Line, Warn, LatDist, LonDist, RxPacket->Packet.DecodeAltitude()-GPS_Altitude/10); // print on the console
+    Len=RxPacket->Packet.WritePFLAA(Line, Warn, RxView, RxView.Altitude-GPS_Altitude/10); // print on the console
     xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
     Format_String(CONS_UART_Write, Line, 0, Len);
     xSemaphoreGive(CONS_Mutex);
 #endif
 #ifdef WITH_MAVLINK
     MAV_ADSB_VEHICLE MAV_RxReport;
-    RxPacket->Packet.Encode(&MAV_RxReport);
+    RxPacket->Packet.Encode(&MAV_RxReport, RxView);
     MAV_RxMsg::Send(sizeof(MAV_RxReport), MAV_Seq++, MAV_SysID, MAV_COMP_ID_ADSB, MAV_ID_ADSB_VEHICLE, (const uint8_t *)&MAV_RxReport, GPS_UART_Write);
 //    xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
 //    MAV_RxMsg::Send(sizeof(MAV_RxReport), MAV_Seq++, MAV_SysID, MAV_COMP_ID_ADSB, MAV_ID_ADSB_VEHICLE, (const uint8_t *)&MAV_RxReport, CONS_UART_Write);
@@ -171,33 +321,51 @@ static void ProcessRxPacket(OGN_RxPacket *RxPacket, uint8_t RxPacketIdx)
   }
 }
 
-static void DecodeRxPacket(RFM_RxPktData *RxPkt)
-{
-  uint8_t RxPacketIdx  = RelayQueue.getNew();                   // get place for this new packet
-  OGN_RxPacket *RxPacket = RelayQueue[RxPacketIdx];
-  // PrintRelayQueue(RxPacketIdx);                              // for debug
-  // RxPacket->RxRSSI=RxPkt.RSSI;
-  // TickType_t ExecTime=xTaskGetTickCount();
-
-  { RX_OGN_Packets++;
-    uint8_t Check = RxPkt->Decode(*RxPacket, Decoder);
+static uint8_t RxPacketSuspect(OGN_RxPacket *RxPacket, uint32_t RxTime, bool Corrected) // acceptance tests (rxcheck.h), RxView already decoded
+{ return OGN_RxCheck::Suspect(*RxPacket, RxView.DistOK, RxTime, GPS_TimeSinceLock>0, RX_AverRSSI, Corrected); }
+
+// good packets go to RX, bad packets go to FEC first: a frame without Manchester errors which passes the parity checks
+// is processed right away, the others are queued to the FEC task (fec.cpp) which runs at a lower priority.
+
+static void TriageRxPacket(RFM_RxPktData *RxPkt)
+{ RX_OGN_Packets++;
+  FEC_Stat.Attempted++;
+  if( RxPkt->NoErr() && (LDPC_Check(RxPkt->Data)==0) )          // clean frame: no need for the FEC
+  { memcpy(RxPacket.Byte(), RxPkt->Data, RxPkt->Bytes);
+    RxPacket.RxErr  = 0;
+    RxPacket.RxChan = RxPkt->Channel;
+    RxPacket.RxRSSI = RxPkt->RSSI;
+    RxPacket.Corr   = 1;
+    RxPacket.Packet.Dewhiten();
+    DecodeRxView(&RxPacket);
+    if(RxPacketSuspect(&RxPacket, RxPkt->Time, 0)) { FEC_Stat.Suspect++; return; }
+    FEC_Stat.Clean++;
+    ProcessRxPacket(&RxPacket, RxPkt->Data, RxPkt->Time);
+    return; }
+  if(FEC_InpFIFO.isFull()) { FEC_Stat.Dropped++; return; }      // FEC is behind: drop rather than delay the time-slot work
+ *FEC_InpFIFO.getWrite() = *RxPkt;
+  FEC_InpFIFO.Write(); }
+
+static void ProcessFEC_Result(FEC_RxResult *Result)             // frame returned by the FEC task
+{ OGN_RxPacket *Corrected = &Result->RxPacket;
 #ifdef DEBUG_PRINT
-    xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
-    Format_String(CONS_UART_Write, "RxPacket: ");
-    Format_Hex(CONS_UART_Write, RxPacket->Packet.HeaderWord);
-    CONS_UART_Write(' ');
-    Format_UnsDec(CONS_UART_Write, (uint16_t)Check);
-    CONS_UART_Write('/');
-    Format_UnsDec(CONS_UART_Write, (uint16_t)RxPacket->RxErr);
-    Format_String(CONS_UART_Write, "\n");
-    xSemaphoreGive(CONS_Mutex);
+  xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
+  Format_String(CONS_UART_Write, "RxPacket: ");
+  Format_Hex(CONS_UART_Write, Corrected->Packet.HeaderWord);
+  CONS_UART_Write(' ');
+  Format_UnsDec(CONS_UART_Write, (uint16_t)Result->Check);
+  CONS_UART_Write('/');
+  Format_UnsDec(CONS_UART_Write, (uint16_t)Corrected->RxErr);
+  Format_String(CONS_UART_Write, "\n");
+  xSemaphoreGive(CONS_Mutex);
 #endif
-    if( (Check==0) && (RxPacket->RxErr<15) )                     // what limit on number of detected bit errors ?
-    { RxPacket->Packet.Dewhiten();
-      ProcessRxPacket(RxPacket, RxPacketIdx); }
-  }
-
-}
+  if( (Result->Check!=0) || (Corrected->RxErr>=15) ) { FEC_Stat.Rejected++; return; } // what limit on number of detected bit errors ?
+  RxPacket = *Corrected;
+  RxPacket.Packet.Dewhiten();
+  DecodeRxView(&RxPacket);
+  if(RxPacketSuspect(&RxPacket, Result->Time, 1)) { FEC_Stat.Suspect++; return; }
+  FEC_Stat.addCorrected(Corrected->RxErr, Result->Iter);
+  ProcessRxPacket(&RxPacket, Corrected->Byte(), Result->Time); }
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -215,6 +383,8 @@ void vTaskPROC(void* pvParameters)
   xSemaphoreGive(CONS_Mutex);
 #endif
   RelayQueue.Clear();
+  Traffic.Clear();
+  TxRate.Clear();
 
   static uint16_t AverSpeed=0;                                          // [0.1m/s] average speed (including vertical)
   static bool     isMoving=0;                                           // is the aircraft moving ?
@@ -240,9 +410,14 @@ void vTaskPROC(void* pvParameters)
       // CONS_UART_Write('\r'); CONS_UART_Write('\n');
       xSemaphoreGive(CONS_Mutex);
 #endif
-      DecodeRxPacket(RxPkt);                                            // decode and process the received packet
+      TriageRxPacket(RxPkt);                                            // process a clean packet or queue it for the FEC
       RF_RxFIFO.Read(); }
 
+    FEC_RxResult *FEC_Result = FEC_OutFIFO.getRead();                   // check for packets which went through the FEC
+    if(FEC_Result)
+    { ProcessFEC_Result(FEC_Result);
+      FEC_OutFIFO.Read(); }
+
     static uint32_t PrevSlotTime=0;                                     // remember previous time slot to detect a change
     uint32_t SlotTime = TimeSync_Time();                                // time slot
     if(TimeSync_msTime()<300) SlotTime--;                               // lasts up to 0.300sec after the PPS
@@ -250,6 +425,7 @@ void vTaskPROC(void* pvParameters)
     if(SlotTime==PrevSlotTime) continue;                                // stil same time slot, go back to RX processing
     PrevSlotTime=SlotTime;                                              // new slot started
                                                                         // this part of the loop is executed only once per slot-time
+    TxRate.Update(RX_OGN_Count64);                                      // follow the channel load
     uint8_t BestIdx; int16_t BestResid;
 #ifdef WITH_MAVLINK
     GPS_Position *Position = GPS_getPosition(BestIdx, BestResid, (SlotTime-1)%60, 0);
@@ -308,11 +484,19 @@ void vTaskPROC(void* pvParameters)
       xSemaphoreGive(CONS_Mutex);
 #endif
       XorShift32(RX_Random);
-      if( isMoving || ((RX_Random&0x3)==0) )                            // send only some positions if the speed is less than 1m/s
+      if( isMoving || TxRate.sendStationary(RX_Random, TX_Credit) )     // send only some positions if the speed is less than 1m/s
         RF_TxFIFO.Write();                                              // complete the write into the TxFIFO
       Position->Sent=1;
+#ifdef WITH_LOOKOUT
+      Look.setOwn(*Position);
+      LookOutTraffic();
+#endif
 #ifdef WITH_PFLAA
-      { uint8_t Len=WritePFLAU(Line);
+#ifdef WITH_LOOKOUT
+      { uint8_t Len=WritePFLAU(Line, 1, Traffic.Count(), &LookAlarm, LookAlarmID);
+#else
+      { uint8_t Len=WritePFLAU(Line, 1, Traffic.Count());
+#endif
         xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
         Format_String(CONS_UART_Write, Line, 0, Len);
         xSemaphoreGive(CONS_Mutex); }
@@ -339,7 +523,7 @@ void vTaskPROC(void* pvParameters)
       xSemaphoreGive(CONS_Mutex);
 #endif
       XorShift32(RX_Random);
-      if(PosTime && ((RX_Random&0x3)==0) )                              // send if some position in the packet and at 1/4 normal rate
+      if(PosTime && TxRate.sendStationary(RX_Random, TX_Credit) )       // send if some position in the packet and at the stationary rate
         RF_TxFIFO.Write();                                              // complete the write into the TxFIFO
       if(Position) Position->Sent=1;
     }
@@ -364,7 +548,7 @@ void vTaskPROC(void* pvParameters)
 #ifdef DEBUG_PRINT
     // char Line[128];
     Line[0]='0'+RF_TxFIFO.Full(); Line[1]=' ';                  // print number of packets in the TxFIFO
-    RelayQueue.Print(Line+2);                                   // dump the relay queue
+    RelayQueue.Print(Line+2, sizeof(Line)-4);                   // dump the relay queue
     xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
     Format_String(CONS_UART_Write, Line);
     xSemaphoreGive(CONS_Mutex);
@@ -393,7 +577,9 @@ void vTaskPROC(void* pvParameters)
       StatusPacket->calcFEC();
       RF_TxFIFO.Write(); }
 
-    while(RF_TxFIFO.Full()<2)
+    XorShift32(RX_Random);
+    uint8_t Relays=TxRate.RelayCount(RX_Random, TX_Credit);     // fewer relays on a busy channel
+    while( Relays && (RF_TxFIFO.Full()<2) )
     { OGN_TxPacket *RelayPacket = RF_TxFIFO.getWrite();
       if(!GetRelayPacket(RelayPacket)) break;
       // xSemaphoreTake(CONS_Mutex, portMAX_DELAY);
@@ -408,9 +594,13 @@ void vTaskPROC(void* pvParameters)
       CONS_UART_Write('\r'); CONS_UART_Write('\n');
       xSemaphoreGive(CONS_Mutex);
 #endif
-      RF_TxFIFO.Write();
+      RF_TxFIFO.Write(); Relays--;
     }
     CleanRelayQueue(SlotTime);
+    Traffic.cleanOld(SlotTime);
+#ifdef WITH_PFLAA
+    PredictTraffic(SlotTime);
+#endif
 
   }
 
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ogn.h"
+
+// overheard relays: several trackers at a launch site hear the same gliders and relay them
+// to a receiver further away (a ground station) which can only hear the relays.
+// Every tracker keeps a relay queue like proc.cpp and transmits up to one relay per second (when it has the credit),
+// the other trackers hear that relay and either queue it like any other packet: with zero rank from calcRelayRank(),
+// which replaces their own packet of that aircraft, or drop their packet with OGN_IndexPrioQueue::overheardRelay()
+// and do not queue the copy: this saves a queue slot (and gives the $POGNR counter) but relays no less airtime,
+// thus it must deliver as many positions and cover as many gliders.
+// compile: g++ -O2 -std=gnu++14 relay_test.cc format.cpp intmath.cpp ldpc.cpp bitcount.cpp -o relay_test
+
+static const int Trackers   =   8;   // relaying trackers at the launch site
+static const int MaxGliders =  40;   // gliders around, each sends a position every second
+static const int RxProb     =  60;   // [%] a tracker receives a given packet
+static const int TxProb     =  50;   // [%] a tracker has the credit to relay in a given second
+static const int Seconds    = 3000;
+static const int MaxAge     =   5;   // [sec] the ground station counts a glider as seen when its position is not older
+
+static uint32_t Rand=1;
+static uint32_t Random(void) { Rand^=Rand<<13; Rand^=Rand>>17; Rand^=Rand<<5; return Rand; }
+static bool     Chance(int Percent) { return (int)(Random()%100)<Percent; }
+
+static OGN_IndexPrioQueue<32> Queue[Trackers];
+
+static void Receive(int Tracker, const OGN_RxPacket &Packet, bool Suppress)
+{ OGN_IndexPrioQueue<32> &RelayQueue = Queue[Tracker];
+  if( Suppress && Packet.Packet.Header.RelayCount && RelayQueue.overheardRelay(Packet.Packet.getAddressAndType()) ) return;
+  uint8_t Idx=RelayQueue.getNew();
+ *RelayQueue[Idx]=Packet;
+  RelayQueue[Idx]->Rank = Packet.Packet.Header.RelayCount ? 0 : 1+Random()%255; // relay rank: calcRelayRank() gives zero to relayed packets
+  RelayQueue.addNew(Idx, Packet.Packet.Position.Time); }
+
+static void Run(int Gliders, bool Suppress, int &Relays, int &Delivered, double &Coverage)
+{ Rand=12345;
+  for(int Tracker=0; Tracker<Trackers; Tracker++) Queue[Tracker].Clear();
+  static int     LastSeen[MaxGliders];                                // [sec] latest position time which reached the ground station
+  static uint8_t Got[MaxGliders][60];                                 // positions which reached the ground station, by time
+  for(int Glider=0; Glider<Gliders; Glider++) { LastSeen[Glider]=(-1000); memset(Got[Glider], 0, 60); }
+  Relays=0; Delivered=0; long Seen=0;
+  for(int Sec=0; Sec<Seconds; Sec++)
+  { uint8_t Time=Sec%60;
+    for(int Glider=0; Glider<Gliders; Glider++) Got[Glider][(Sec+30)%60]=0; // forget positions half a minute old
+    for(int Glider=0; Glider<Gliders; Glider++)                   // every glider sends its position
+    { OGN_RxPacket Packet; Packet.Clear();
+      Packet.Packet.Header.Address=0x100+Glider; Packet.Packet.Header.AddrType=2;
+      Packet.Packet.Position.Time=Time;
+      for(int Tracker=0; Tracker<Trackers; Tracker++)
+        if(Chance(RxProb)) Receive(Tracker, Packet, Suppress); }
+    int First=Random()%Trackers;
+    for(int Turn=0; Turn<Trackers; Turn++)                        // the trackers relay one after another within the second
+    { int Tracker=(First+Turn)%Trackers;
+      OGN_IndexPrioQueue<32> &RelayQueue = Queue[Tracker];
+      if(!Chance(TxProb) || RelayQueue.getSum()==0) continue;
+      uint8_t Idx=RelayQueue.getRand(Random());
+      if(RelayQueue[Idx]->Rank==0) continue;
+      OGN_RxPacket Relay = *RelayQueue[Idx];                       // like GetRelayPacket()
+      Relay.Packet.Header.RelayCount+=1;
+      RelayQueue.decrRank(Idx);
+      Relays++;
+      int Glider=Relay.Packet.Header.Address-0x100;               // the ground station hears all relays
+      uint8_t PosTime=Relay.Packet.Position.Time;
+      if(!Got[Glider][PosTime]) { Got[Glider][PosTime]=1; Delivered++; }
+      int Age=(Time+60-PosTime)%60;
+      if(Sec-Age>LastSeen[Glider]) LastSeen[Glider]=Sec-Age;
+      for(int Other=0; Other<Trackers; Other++)                   // and so do the other trackers, sometimes
+        if( (Other!=Tracker) && Chance(RxProb) ) Receive(Other, Relay, Suppress); }
+    for(int Tracker=0; Tracker<Trackers; Tracker++)
+      Queue[Tracker].cleanTime((Sec+60-20)%60);
+    for(int Glider=0; Glider<Gliders; Glider++)
+      if(Sec-LastSeen[Glider]<=MaxAge) Seen++; }
+  Coverage = (double)Seen/(Seconds*Gliders); }
+
+int main(int argc, char *argv[])
+{ bool OK=1;
+  for(int Gliders=10; Gliders<=MaxGliders; Gliders*=2)
+  { int Relays[2], Delivered[2]; double Coverage[2];
+    printf("%d trackers relay %d gliders, %d%% reception, %d%% transmit credit\n", Trackers, Gliders, RxProb, TxProb);
+    for(int Suppress=0; Suppress<2; Suppress++)
+    { Run(Gliders, Suppress, Relays[Suppress], Delivered[Suppress], Coverage[Suppress]);
+      printf("  %-16s %6d relays, %6d different positions delivered = %4.1f%% useful, gliders seen within %ds: %4.1f%%\n",
+             Suppress ? "copy dropped:":"copy queued:", Relays[Suppress], Delivered[Suppress], 100.0*Delivered[Suppress]/Relays[Suppress],
+             MaxAge, 100.0*Coverage[Suppress]); }
+    double Gain = ((double)Delivered[1]/Relays[1])/((double)Delivered[0]/Relays[0]);
+    printf("  useful relays per transmission: x%5.3f\n", Gain);
+    if( (Gain<0.995) || (Coverage[1]<Coverage[0]-0.005) ) OK=0; }
+  printf("%s\n", OK ? "OK":"FAILED");
+  return !OK; }
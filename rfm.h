@@ -1,3 +1,6 @@
+#ifndef __RFM_H__
+#define __RFM_H__
+
 // -----------------------------------------------------------------------------------------------------------------------
 
 #include "ogn.h"
@@ -12,6 +15,9 @@ class RFM_RxPktData                  // packet received by the RF chip
    uint8_t Data[Bytes];             // Manchester decoded data bits/bytes
    uint8_t Err [Bytes];             // Manchester decoding errors
 
+   static const uint8_t NearErrWeight=16; // [1/16] relative reliability of bits next to Manchester errors: 16 = not reduced
+                                          // any lower weight costs sensitivity (ldpc_fer -c manch -w 12) while it helps only against bursts (-c burst)
+
   public:
 
    void Print(void (*CONS_UART_Write)(char), uint8_t WithData=0) const
@@ -33,6 +39,8 @@ class RFM_RxPktData                  // packet received by the RF chip
      CONS_UART_Write('\r'); CONS_UART_Write('\n');
    }
 
+   uint8_t Slot(void) const { return msTime>=800; }     // 0 = first time slot (0.4-0.8sec), 1 = second (0.8-1.2sec)
+
    bool NoErr(void) const
    { for(uint8_t Idx=0; Idx<Bytes; Idx++)
        if(Err[Idx]) return 0;
@@ -50,14 +58,58 @@ class RFM_RxPktData                  // packet received by the RF chip
        Count+=Count1s((uint8_t)((Data[Idx]^Corr[Idx])&(~Err[Idx])));
      return Count; }
 
-  uint8_t Decode(OGN_RxPacket &Packet, LDPC_Decoder &Decoder, uint8_t Iter=32) const
-  { uint8_t Check=0;
+   // [1/16] reliability of the bits from the signal-to-noise ratio: only the ratio between two receptions matters,
+   // a single reception is not scaled as the 8-bit decoder loses on small input amplitudes
+   uint8_t Weight(uint8_t NoiseRSSI) const
+   { static const uint8_t Table[13] = { 3, 4, 5, 6, 8, 9, 11, 13, 16, 19, 24, 29, 32 }; // LLR of hard FSK bits for 0..12dB, scaled to 16 at 8dB
+     if(NoiseRSSI==0) return 16;                         // noise level not known
+     int16_t SNR = ((int16_t)NoiseRSSI-RSSI)>>1;         // [dB] RSSI is in -0.5dBm units
+     if(SNR<0) SNR=0; else if(SNR>12) SNR=12;
+     return Table[SNR]; }
+
+   template <class LDPC_Dec>
+    void Input(LDPC_Dec &Decoder, uint8_t W=16) const     // [1/16] weighted input into the FEC decoder
+   { Decoder.Input(Data, Err, W, (W*NearErrWeight+8)>>4); }
+
+   template <class LDPC_Dec>
+    void addInput(LDPC_Dec &Decoder, uint8_t W=16) const  // add to an earlier input: soft combining
+   { Decoder.addInput(Data, Err, W, (W*NearErrWeight+8)>>4); }
+
+   uint8_t Distance(const RFM_RxPktData &Other) const   // count differing bits, which are not erased in either packet
+   { uint8_t Count=0;
+     for(uint8_t Idx=0; Idx<Bytes; Idx++)
+       Count+=Count1s((uint8_t)((Data[Idx]^Other.Data[Idx])&(~(Err[Idx]|Other.Err[Idx]))));
+     return Count; }
+
+   uint8_t ErrCount(const RFM_RxPktData &Other, const uint8_t *Corr) const // count bits of two combined receptions not confirmed by the corrected data
+   { uint8_t Count=0;
+     for(uint8_t Idx=0; Idx<Bytes; Idx++)
+     { uint8_t Good      = (~(      Data[Idx]^Corr[Idx]))&(~      Err[Idx]); // bits which agree with the corrected data
+       uint8_t Bad       =  (       Data[Idx]^Corr[Idx]) &(~      Err[Idx]); // bits which disagree
+       uint8_t OtherGood = (~(Other.Data[Idx]^Corr[Idx]))&(~Other.Err[Idx]);
+       uint8_t OtherBad  =  ( Other.Data[Idx]^Corr[Idx]) &(~Other.Err[Idx]);
+       Count+=Count1s((uint8_t)~((Good&(~OtherBad))|(OtherGood&(~Bad)))); } // the sum was zero or had the wrong sign
+     return Count; }
+
+  template <class LDPC_Dec>                                    // LDPC_Decoder (flooding) or LDPC_LayeredDecoder<>
+  uint8_t Decode(OGN_RxPacket &Packet, LDPC_Dec &Decoder, uint8_t Iter=32, uint8_t *IterUsed=0) const
+  { uint8_t Check=0; uint8_t Used=0;                          // Used: count soft-decoder iterations
     uint8_t RxErr = ErrCount();                                // conunt Manchester decoding errors
-    Decoder.Input(Data, Err);                                  // put data into the FEC decoder
-    for( ; Iter; Iter--)                                       // more loops is more chance to recover the packet
-    { Check=Decoder.ProcessChecks();                           // do an iteration
-      if(Check==0) break; }                                    // if FEC all fine: break
-    Decoder.Output(Packet.Packet.Byte());                      // get corrected bytes into the OGN packet
+    uint32_t Word[7], Erased[7];                               // try the fast hard-decision bit-flipping first
+    Word[6]=0; Erased[6]=0;
+    memcpy(Word, Data, Bytes); memcpy(Erased, Err, Bytes);
+    Check=LDPC_FlipBits(Word, Erased);
+    if(Check==0) memcpy(Packet.Packet.Byte(), Word, Bytes);    // bit-flipping found a valid codeword
+    else                                                       // otherwise run the soft decoder
+    { Input(Decoder);                                          // put data into the FEC decoder: a single reception needs no RSSI scaling
+      LDPC_EarlyStop Stop;                                     // give up early on noise and non-OGN frames
+      for( ; Iter; Iter--)                                     // more loops is more chance to recover the packet
+      { Check=Decoder.ProcessChecks();                         // do an iteration
+        if(Check==0) break;                                    // if FEC all fine: break
+        Used++;
+        if(Stop.Stop(Check, Decoder)) break; }                 // if stagnating or oscillating: break
+      Decoder.Output(Packet.Packet.Byte()); }                  // get corrected bytes into the OGN packet
+    if(IterUsed) *IterUsed=Used;
     RxErr += ErrCount(Packet.Packet.Byte());
     if(RxErr>15) RxErr=15;
     Packet.RxErr  = RxErr;
@@ -66,6 +118,30 @@ class RFM_RxPktData                  // packet received by the RF chip
     Packet.Corr   = Check==0;
     return Check; }
 
+  template <class LDPC_Dec>                                    // combine with another (failed) reception of the same packet and decode
+  uint8_t Decode(OGN_RxPacket &Packet, const RFM_RxPktData &Other, LDPC_Dec &Decoder, uint8_t Iter=32, uint8_t *IterUsed=0, uint8_t NoiseRSSI=0) const
+  { uint8_t Check=0; uint8_t Used=0;
+    uint8_t W=Weight(NoiseRSSI); uint8_t OtherW=Other.Weight(NoiseRSSI);
+    if(W>=OtherW) { OtherW=(16*OtherW+W/2)/W; W=16; }          // the stronger reception gets the nominal weight
+             else { W=(16*W+OtherW/2)/OtherW; OtherW=16; }     // the weaker one proportionally less
+    Input(Decoder, W);                                         // soft (Chase) combining: sum the bits of both receptions
+    Other.addInput(Decoder, OtherW);                           // bits where they disagree become erasures
+    LDPC_EarlyStop Stop;
+    for( ; Iter; Iter--)
+    { Check=Decoder.ProcessChecks();
+      if(Check==0) break;
+      Used++;
+      if(Stop.Stop(Check, Decoder)) break; }
+    Decoder.Output(Packet.Packet.Byte());
+    if(IterUsed) *IterUsed=Used;
+    uint8_t RxErr = ErrCount(Other, Packet.Packet.Byte());
+    if(RxErr>15) RxErr=15;
+    Packet.RxErr  = RxErr;
+    Packet.RxChan = Channel;
+    Packet.RxRSSI = RSSI<Other.RSSI ? RSSI:Other.RSSI;         // the stronger of the two (RSSI is in -0.5dBm)
+    Packet.Corr   = Check==0;
+    return Check; }
+
 } ;
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -483,4 +559,4 @@ class RFM_TRX
 */
 } ;
 
-
+#endif // __RFM_H__
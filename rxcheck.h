@@ -0,0 +1,51 @@
+#ifndef __RXCHECK_H__
+#define __RXCHECK_H__
+
+#include <stdint.h>
+
+#include "ogn.h"
+
+// Acceptance tests for a received frame: more iterations and soft combining recover more packets
+// but as well make it more likely that noise or a badly damaged frame is "corrected" into a valid but false codeword.
+// Such ghost targets must not reach the console nor the relay queue, thus the frame must look like a real OGN packet.
+// Ghosts come only out of the FEC: a clean frame (no Manchester errors, all parity checks pass) is not tested
+// for the time and distance, as a tracker which lost its GPS fix keeps sending its last position with the old time
+// for 30 sec (proc.cpp). A held position which needed correction is dropped, its clean copies still get through.
+
+class OGN_RxCheck
+{ public:
+   static const uint8_t MaxAge      =  2;     // [sec] how old can be the position time of a direct packet
+   static const uint8_t MaxRelayAge = 22;     // [sec] of a relayed packet: they are kept in the relay queue for up to 20 sec
+   static const uint8_t MaxAhead    =  1;     // [sec] how much into the future, for timing errors
+
+   static uint8_t MaxErr(uint8_t RxRSSI, uint8_t NoiseRSSI) // [bits] strong signals are not expected to carry many bit errors
+   { if(NoiseRSSI==0) return 14;                            // noise level not known
+     int16_t SNR = ((int16_t)NoiseRSSI-RxRSSI)>>1;           // [dB] RSSI is in -0.5dBm units
+     if(SNR<=10) return 14;
+     int16_t Max = 14-((SNR-10)>>1);                         // one bit less for every 2dB above 10dB
+     if(Max<6) Max=6;
+     return Max; }
+
+   // returns non-zero when the (dewhitened) packet fails a test: 1 = address parity, 2 = too many bit errors,
+   // 3 = position time outside the window, 4 = beyond the radio range.
+   // DistOK from OGN_PacketView::calcDistance(), RxTime [sec] of the reception, TimeKnown when we have a GPS lock,
+   // NoiseRSSI [-0.5dBm] the average noise level (zero when not known), Corrected when the frame came out of the FEC.
+   static uint8_t Suspect(const OGN_RxPacket &RxPacket, int8_t DistOK, uint32_t RxTime, bool TimeKnown, uint8_t NoiseRSSI, bool Corrected)
+   { const OGN_Packet &Packet = RxPacket.Packet;
+     if(!Packet.goodAddrParity()) return 1;                  // address parity is not covered by the FEC thus it gives an independent check
+     if(!Corrected) return 0;                                // clean frame: not a ghost
+     if(RxPacket.RxErr>MaxErr(RxPacket.RxRSSI, NoiseRSSI)) return 2; // too many corrected bits for the signal strength
+     if(Packet.Header.Encrypted) return 0;                   // the rest is not readable
+     if(!TimeKnown) return 0;                                // without a GPS lock we know neither the time nor our position
+     uint8_t Time = Packet.Position.Time;                    // same place in the status packet
+     if(Time<60)                                             // 60..63 means the time is not known
+     { uint8_t Age = (RxTime%60+60-Time)%60;                 // [sec] how old is the position
+       uint8_t Max = Packet.Header.RelayCount ? MaxRelayAge:MaxAge;
+       if( (Age>Max) && (Age<(60-MaxAhead)) ) return 3; }
+     if(Packet.Header.Other) return 0;                       // status packets carry no position
+     if(DistOK<0) return 4;                                  // beyond the radio range
+     return 0; }
+
+} ;
+
+#endif // __RXCHECK_H__
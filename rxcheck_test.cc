@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ogn.h"
+#include "rxcheck.h"
+
+// acceptance tests of received frames (rxcheck.h): a tracker which lost its GPS fix keeps sending its last position
+// with the old time for 30 sec, then with the time unknown: its clean frames must all be accepted,
+// while frames out of the FEC with such an old time are taken as ghosts. Noise "corrected" by the FEC
+// into random header bits must mostly be rejected.
+// compile: g++ -O2 -std=gnu++14 rxcheck_test.cc format.cpp intmath.cpp ldpc.cpp bitcount.cpp -o rxcheck_test
+
+static const uint8_t NoiseRSSI = 2*110;                          // [-0.5dBm] -110dBm noise floor
+
+static void Position(OGN_RxPacket &RxPacket, uint8_t Time, uint8_t RelayCount, uint8_t RxErr)
+{ RxPacket.Clear();
+  RxPacket.Packet.Header.Address    = 0x123456;
+  RxPacket.Packet.Header.AddrType   = 2;
+  RxPacket.Packet.Header.RelayCount = RelayCount;
+  RxPacket.Packet.calcAddrParity();
+  RxPacket.Packet.Position.Time     = Time;
+  RxPacket.RxErr  = RxErr;
+  RxPacket.RxRSSI = 2*100; }                                     // -100dBm: 5dB above the noise
+
+int main(int argc, char *argv[])
+{ int Errors=0;
+  OGN_RxPacket RxPacket;
+
+  const uint32_t FixLost = 1000;                                 // [sec] the sender has its last fix at this second
+  int CleanRejected=0, CorrRejected=0, CorrExpected=0;
+  for(uint32_t RxTime=FixLost; RxTime<FixLost+40; RxTime++)      // the sender holds the position for 30 sec, then sends the time as unknown
+  { uint8_t Time = (RxTime-FixLost)<30 ? FixLost%60 : 0x3F;
+    Position(RxPacket, Time, 0, 0);
+    if(OGN_RxCheck::Suspect(RxPacket, 0, RxTime, 1, NoiseRSSI, 0)) CleanRejected++;
+    Position(RxPacket, Time, 0, 3);
+    if(OGN_RxCheck::Suspect(RxPacket, 0, RxTime, 1, NoiseRSSI, 1)) CorrRejected++;
+    if( (Time<60) && ((RxTime-FixLost)>OGN_RxCheck::MaxAge) ) CorrExpected++; }
+  printf("held position over 40 sec: %d clean frames rejected, %d of the corrected ones (expected %d)\n",
+         CleanRejected, CorrRejected, CorrExpected);
+  if(CleanRejected) Errors++;
+  if(CorrRejected!=CorrExpected) Errors++;
+
+  Position(RxPacket, 10, 1, 3);                                  // relays are kept for up to 20 sec in the relay queue
+  if(OGN_RxCheck::Suspect(RxPacket, 0, 30, 1, NoiseRSSI, 1)) Errors++;
+  if(!OGN_RxCheck::Suspect(RxPacket, 0, 40, 1, NoiseRSSI, 1)) Errors++;
+
+  Position(RxPacket, 10, 0, 0);                                  // a clean frame with a bad address parity is not an OGN packet
+  RxPacket.Packet.HeaderWord ^= 0x08000000;
+  if(OGN_RxCheck::Suspect(RxPacket, 0, 10, 1, NoiseRSSI, 0)!=1) Errors++;
+
+  srandom(12345);                                                // ghosts: random header and time out of the FEC
+  int Ghosts=10000, Accepted=0;
+  for(int Idx=0; Idx<Ghosts; Idx++)
+  { Position(RxPacket, 0, 0, random()%15);
+    RxPacket.Packet.HeaderWord = ((uint32_t)random()<<16) ^ random();
+    RxPacket.Packet.Position.Time = random()&0x3F;
+    RxPacket.Packet.Header.Other = 0;                           // status and encrypted packets do not reach the console anyway
+    RxPacket.Packet.Header.Encrypted = 0;
+    if(!OGN_RxCheck::Suspect(RxPacket, 0, 1000, 1, NoiseRSSI, 1)) Accepted++; }
+  printf("ghost decodes: %4.1f%% accepted\n", 100.0*Accepted/Ghosts);
+  if(Accepted*5>Ghosts) Errors++;                                // parity leaves 1/2, the time window 8/64 of direct and 28/64 of relayed ones: 18%
+
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }
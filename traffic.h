@@ -0,0 +1,107 @@
+#ifndef __TRAFFIC_H__
+#define __TRAFFIC_H__
+
+#include <stdint.h>
+
+#include "ogn.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+class OGN_TrafficTarget                        // what we know about an aircraft around us
+{ public:
+   uint32_t       AddressAndType;             // address-type and address (2+24 = 26 bits)
+   uint32_t       RxTime;                     // [sec] time slot of the last reception
+   OGN_PacketView View;                       // last decoded position
+   uint8_t        Time;                       // [sec] position time stamp of View
+   uint8_t        AcftType;                   // [0..15] aircraft-type: 1=glider, 2=tow plane, etc.
+   uint8_t        RxRSSI;                     // [-0.5dBm] of the last reception
+   uint8_t        BestRSSI;                   // [-0.5dBm] strongest reception
+   uint8_t        AverRSSI;                   // [-0.5dBm] average over receptions
+   uint16_t       RxCount;                    // number of receptions
+   uint16_t       PosCount;                   // number of different positions (time stamps)
+   uint8_t        Relayed;                    // the last reception was a relayed packet
+   uint8_t        Alarm;                      // alarm level set by the lookout
+
+  public:
+   void Clear(void) { AddressAndType=0; RxTime=0; RxCount=0; PosCount=0; Alarm=0; }
+
+   bool isFree(void) const { return RxCount==0; }
+
+   uint32_t Age(uint32_t Now) const { return Now-RxTime; }  // [sec] since the last reception
+
+   void addRSSI(uint8_t RSSI)
+   { RxRSSI=RSSI;
+     if(RxCount==1) { BestRSSI=AverRSSI=RSSI; return; }
+     if(RSSI<BestRSSI) BestRSSI=RSSI;                        // lower value => stronger signal
+     AverRSSI = ((uint16_t)3*AverRSSI+RSSI+2)>>2; }
+
+} ;
+
+// a target is transmitting in both time slots and can be heard directly and through relays:
+// the table keeps one entry per aircraft and tells, which reception carries a position not yet seen.
+
+template<uint8_t TableSize=16>
+ class OGN_TrafficTable
+{ public:
+   static const uint8_t MaxAge = 60;          // [sec] drop targets not heard for that long
+   static const uint8_t DuplAge = 30;         // [sec] same time stamp within that time is the same position
+
+   static const uint8_t Size = TableSize;
+   OGN_TrafficTarget Target[Size];
+
+  public:
+   void Clear(void)
+   { for(uint8_t Idx=0; Idx<Size; Idx++) Target[Idx].Clear(); }
+
+   OGN_TrafficTarget * operator [](uint8_t Idx) { return Target+Idx; }
+
+   int8_t Find(uint32_t AddressAndType) const                // index of the target or -1 when not in the table
+   { for(uint8_t Idx=0; Idx<Size; Idx++)
+     { if( (!Target[Idx].isFree()) && (Target[Idx].AddressAndType==AddressAndType) ) return Idx; }
+     return -1; }
+
+   // enter a reception: returns the target index, IsNew is set when this position is newer than the one in the table.
+   // A relay can arrive after the direct reception of a later position: an older time stamp is treated like a duplicate,
+   // it only refreshes the RSSI and the reception time.
+   uint8_t Update(const OGN_RxPacket &RxPacket, const OGN_PacketView &View, uint32_t RxTime, bool &IsNew)
+   { uint32_t AddressAndType = RxPacket.Packet.getAddressAndType();
+     uint8_t Time = RxPacket.Packet.Position.Time;
+     if(Time>=60) Time=RxTime%60;                            // time not known: take the reception time, as the relay queue does
+     int8_t Idx = Find(AddressAndType);
+     if(Idx<0) Idx=getFree(RxTime);
+     OGN_TrafficTarget &Entry = Target[Idx];
+     uint8_t Newer = (Time+60-Entry.Time)%60;                // [sec] how much newer is this time stamp (modulo 60)
+     IsNew = Entry.isFree() || (Entry.AddressAndType!=AddressAndType)
+          || ( (Newer>0) && (Newer<DuplAge) ) || (Entry.Age(RxTime)>=DuplAge);
+     if(Entry.AddressAndType!=AddressAndType) { Entry.Clear(); Entry.AddressAndType=AddressAndType; }
+     if(Entry.RxCount<0xFFFF) Entry.RxCount++;
+     Entry.addRSSI(RxPacket.RxRSSI);
+     Entry.RxTime=RxTime;
+     if(IsNew)
+     { Entry.View=View; Entry.Time=Time; Entry.AcftType=RxPacket.Packet.Position.AcftType;
+       Entry.Relayed=RxPacket.Packet.Header.RelayCount>0;
+       if(Entry.PosCount<0xFFFF) Entry.PosCount++; }
+     return Idx; }
+
+   void cleanOld(uint32_t Now)                               // remove targets not heard for MaxAge
+   { for(uint8_t Idx=0; Idx<Size; Idx++)
+     { if( (!Target[Idx].isFree()) && (Target[Idx].Age(Now)>=MaxAge) ) Target[Idx].Clear(); }
+   }
+
+   uint8_t Count(void) const                                 // number of targets in the table
+   { uint8_t Count=0;
+     for(uint8_t Idx=0; Idx<Size; Idx++) if(!Target[Idx].isFree()) Count++;
+     return Count; }
+
+  private:
+   uint8_t getFree(uint32_t Now) const                       // a free entry or the one not heard for the longest time
+   { uint8_t OldIdx=0; uint32_t OldAge=0;
+     for(uint8_t Idx=0; Idx<Size; Idx++)
+     { if(Target[Idx].isFree()) return Idx;
+       uint32_t Age=Target[Idx].Age(Now);
+       if(Age>=OldAge) { OldAge=Age; OldIdx=Idx; } }
+     return OldIdx; }
+
+} ;
+
+#endif // __TRAFFIC_H__
@@ -0,0 +1,55 @@
+#ifndef __TXRATE_H__
+#define __TXRATE_H__
+
+#include <stdint.h>
+
+// Transmit rate control by the channel load: RX_OGN_Count64 (OGN packets heard in the last 64 seconds) sets the load level.
+// As the channel gets busier the relays are cut first, then the positions of a stationary tracker;
+// positions of a moving aircraft are never cut. On a quiet channel a stationary tracker sends more often,
+// but only while it has saved TX_Credit which the 1% duty cycle would otherwise leave unused.
+// The level moves only when the load is well past the threshold, thus it does not flip with every packet.
+
+class OGN_TxRate
+{ public:
+   static const uint8_t  Levels = 6;            // 0: below 1 packet/sec, then every level doubles the load: 5 = above 16 packets/sec
+   static const uint16_t QuietCount = 64;       // [packets/64sec] upper limit of level 0
+   static const uint16_t CreditLow  = 20;       // [packets] below that not more than one relay per slot: keep the credit for own positions
+   static const uint16_t CreditHigh = 240;      // [packets] above that a quiet channel gets more positions from a stationary tracker
+
+   uint8_t Level;                               // [0..Levels-1] current load level
+
+  public:
+   OGN_TxRate() { Clear(); }
+
+   void Clear(void) { Level=1; }                // start at the rates used without the load control
+
+   static uint8_t LoadLevel(uint32_t Count)     // [packets/64sec] => load level without hysteresis
+   { uint8_t Level=0; Count/=QuietCount;
+     while(Count && (Level<(Levels-1))) { Count>>=1; Level++; }
+     return Level; }
+
+   uint8_t Update(uint16_t RxCount64)           // once per second with RX_OGN_Count64: returns the new level
+   { uint32_t Count = RxCount64;
+     uint8_t Up   = LoadLevel(Count-(Count>>2));                 // go up when 1/3 above the threshold
+     uint8_t Down = LoadLevel(Count+(Count>>2));                 // go down when 1/5 below
+     if(Up>Level) Level=Up;
+     else if(Down<Level) Level=Down;
+     return Level; }
+
+   uint8_t RelayCount(uint32_t Random, uint16_t Credit) const   // how many relays to put into the TxFIFO in this slot
+   { static const uint8_t MaxRelays[Levels] = {  2,  2,  1, 1, 1, 0 };
+     static const uint8_t RelayProb[Levels] = { 16, 16, 16, 8, 4, 0 }; // [1/16] chance to relay at all in a slot
+     if((Random&0xF)>=RelayProb[Level]) return 0;
+     uint8_t Count=MaxRelays[Level];
+     if( (Credit<CreditLow) && (Count>1) ) Count=1;
+     return Count; }
+
+   bool sendStationary(uint32_t Random, uint16_t Credit) const  // should a stationary tracker send its position in this slot
+   { static const uint8_t PosProb[Levels] = { 8, 4, 4, 4, 2, 1 }; // [1/16]
+     uint8_t Prob = PosProb[Level];
+     if( (Level==0) && (Credit<CreditHigh) ) Prob=PosProb[1];    // more positions only from the saved credit
+     return ((Random>>4)&0xF)<Prob; }
+
+} ;
+
+#endif // __TXRATE_H__
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "txrate.h"
+
+// channel-load rate control (txrate.h): the load is swept up and down like RX_OGN_Count64 would follow it,
+// the relays and the stationary positions per slot are counted at every level:
+// relays must be cut first, both must only go down with the load, the level must not flip on a noisy load
+// and the quiet-channel extra positions must come only from saved credit.
+// compile: g++ -O2 -std=gnu++14 txrate_test.cc -o txrate_test
+
+static uint32_t Rand=1;
+static uint32_t Random(void) { Rand^=Rand<<13; Rand^=Rand>>17; Rand^=Rand<<5; return Rand; }
+
+static void Rates(OGN_TxRate &Rate, uint16_t Credit, int &Relays, int &Positions) // per 256 slots at the current level
+{ Relays=0; Positions=0;
+  for(int Slot=0; Slot<256; Slot++)                               // all values of the random bits which the controller uses
+  { Relays+=Rate.RelayCount(Slot, Credit);
+    Positions+=Rate.sendStationary(Slot, Credit); }
+}
+
+int main(int argc, char *argv[])
+{ int Errors=0;
+  OGN_TxRate Rate;
+  int PrevRelays=10000, PrevPositions=10000;
+  printf("packets/64s level relays/256s positions/256s\n");
+  for(uint16_t Count=16; Count<=4096; Count*=2)                   // sweep up: give the level time to settle
+  { for(int Sec=0; Sec<64; Sec++) Rate.Update(Count);
+    int Relays, Positions; Rates(Rate, 1000, Relays, Positions);
+    printf("  %5d     %d    %5d       %5d\n", Count, Rate.Level, Relays, Positions);
+    if( (Relays>PrevRelays) || (Positions>PrevPositions) ) Errors++;        // only down with the load
+    if( (Rate.Level>1) && (Positions<PrevPositions) && (Relays>0) && (Relays==PrevRelays) ) Errors++; // positions cut while relays are not
+    PrevRelays=Relays; PrevPositions=Positions; }
+  if(PrevRelays!=0) Errors++;                                     // saturated channel: no relays
+  if(PrevPositions==0) Errors++;                                  // but the stationary position still goes out sometimes
+
+  for(uint16_t Count=4096; Count>=16; Count/=2) for(int Sec=0; Sec<64; Sec++) Rate.Update(Count);
+  printf("back to quiet: level %d\n", Rate.Level);
+  if(Rate.Level!=0) Errors++;
+
+  int Changes=0;                                                  // load noisy around a threshold (+/-15%)
+  Rate.Clear(); for(int Sec=0; Sec<64; Sec++) Rate.Update(256);
+  for(int Sec=0; Sec<3600; Sec++)
+  { uint8_t Prev=Rate.Level;
+    Rate.Update(256-38+Random()%77);
+    if(Rate.Level!=Prev) Changes++; }
+  printf("load 256+/-15%%: %d level changes in an hour\n", Changes);
+  if(Changes) Errors++;
+
+  Rate.Clear(); for(int Sec=0; Sec<64; Sec++) Rate.Update(16);   // quiet channel: extra positions only with saved credit
+  int Relays, LowPositions, HighPositions;
+  Rates(Rate, OGN_TxRate::CreditHigh,   Relays, HighPositions);
+  Rates(Rate, OGN_TxRate::CreditLow-1,  Relays, LowPositions);
+  printf("quiet: %d positions/256s with saved credit, %d relays/256s on low credit\n", HighPositions, Relays);
+  if(HighPositions<=LowPositions) Errors++;
+  if(Relays>256) Errors++;                                        // low credit: not more than one relay per slot
+
+  printf("%s\n", Errors ? "FAILED":"OK");
+  return Errors!=0; }